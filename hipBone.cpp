@@ -28,8 +28,16 @@ SOFTWARE.
 
 int main(int argc, char **argv){
 
+  // the ogs progress thread needs MPI_THREAD_MULTIPLE, which has to be
+  // requested before the settings can be parsed
+  bool threadMultiple = false;
+  for (int n=1;n<argc-1;++n) {
+    if (!strcmp(argv[n], "-opt") || !strcmp(argv[n], "--ogs-progress-thread"))
+      threadMultiple = !strcmp(argv[n+1], "TRUE");
+  }
+
   // start up MPI
-  comm_t::Init(argc, argv);
+  comm_t::Init(argc, argv, threadMultiple);
 
   { /*Scope so everything is destructed before MPI_Finalize */
     comm_t comm(comm_t::world().Dup());
@@ -49,6 +57,16 @@ int main(int argc, char **argv){
 
     // run
     hb.Run();
+
+    // report ogs exchange statistics
+    if (settings.compareSetting("OGS STATS", "TRUE")) {
+      std::string matrixFile;
+      if (!settings.compareSetting("OGS COMM MATRIX", "NONE"))
+        matrixFile = settings.getSetting("OGS COMM MATRIX");
+      ogs::ReportStats(comm, matrixFile);
+    }
+
+    ogs::StopProgressThread();
   }
 
   // close down MPI
@@ -28,6 +28,7 @@ SOFTWARE.
 #define LIBP_COMM_HPP
 
 #include <mpi.h>
+#include <map>
 #include "core.hpp"
 
 namespace libp {
@@ -72,21 +73,28 @@ class comm_t {
   int _rank=0;
   int _size=0;
 
+  /*tag reserved for the sparse setup exchanges*/
+  static constexpr int sparseTag = 0x5a5;
+
  public:
   comm_t() = default;
   comm_t(const comm_t &c) = default;
   comm_t& operator = (const comm_t &c)=default;
 
   /*Static MPI_Init and MPI_Finalize*/
-  static void Init(int &argc, char** &argv);
+  static void Init(int &argc, char** &argv, const bool threadMultiple=false);
   static void Finalize();
 
+  /*True if MPI was initialized with MPI_THREAD_MULTIPLE support*/
+  static bool ThreadMultiple();
+
   /*Static handle to MPI_COMM_WORLD*/
   static comm_t world();
 
   /*MPI_Comm_dup and MPI_Comm_delete*/
   comm_t Dup() const;
   comm_t Split(const int color, const int key) const;
+  comm_t SplitShared(const int key) const;
   void Free();
 
   /*Rank and size getters*/
@@ -97,6 +105,7 @@ class comm_t {
   MPI_Comm comm() const;
 
   using request_t = MPI_Request;
+  using datatype_t = MPI_Datatype;
 
   /*Predefined ops*/
   using op_t = MPI_Op;
@@ -164,6 +173,40 @@ class comm_t {
     mpiType<T>::freeMpiType(type);
   }
 
+  /*libp::memory non-blocking send of one derived datatype element*/
+  template <template<typename> class mem, typename T>
+  void IsendType(mem<T> m,
+                 const int dest,
+                 const datatype_t type,
+                 const int tag,
+                 request_t &request) const {
+    MPI_Isend(m.ptr(), 1, type, dest, tag, comm(), &request);
+  }
+
+  /*Committed derived datatype of count blocks of blocklength entries,
+    at displacements counted in entries*/
+  template <typename T>
+  datatype_t TypeIndexedBlock(const int count,
+                              const int blocklength,
+                              const int *displacements) const {
+    MPI_Datatype type = mpiType<T>::getMpiType();
+    MPI_Datatype newtype;
+    MPI_Type_create_indexed_block(count, blocklength, displacements,
+                                  type, &newtype);
+    MPI_Type_commit(&newtype);
+    mpiType<T>::freeMpiType(type);
+    return newtype;
+  }
+
+  /*Pack one derived datatype element into a contiguous buffer*/
+  template <template<typename> class mem, typename T>
+  void Pack(const mem<T> m,
+            const datatype_t type,
+            memory<char> buf) const {
+    int position=0;
+    MPI_Pack(m.ptr(), 1, type, buf.ptr(), buf.length(), &position, comm());
+  }
+
   /*libp::memory non-blocking recv*/
   template <template<typename> class mem, typename T>
   void Irecv(mem<T> m,
@@ -411,6 +454,22 @@ class comm_t {
     mpiType<T>::freeMpiType(type);
   }
 
+  /*libp::memory non-blocking gatherv*/
+  template <template<typename> class mem, typename T>
+  void Igatherv(const mem<T> snd,
+                const int sendcount,
+                      mem<T> rcv,
+                const memory<int> recvCounts,
+                const memory<int> recvOffsets,
+                const int root,
+                request_t &request) const {
+    MPI_Datatype type = mpiType<T>::getMpiType();
+    MPI_Igatherv(snd.ptr(), sendcount, type,
+                 rcv.ptr(), recvCounts.ptr(), recvOffsets.ptr(), type,
+                 root, comm(), &request);
+    mpiType<T>::freeMpiType(type);
+  }
+
   /*scalar gather*/
   template <template<typename> class mem, typename T>
   void Gather(const T& snd,
@@ -546,10 +605,187 @@ class comm_t {
     mpiType<T>::freeMpiType(type);
   }
 
+  /*libp::memory sparse alltoallv with an unknown pattern. Only ranks with
+    nonzero sendCounts are messaged, and the senders are discovered with the
+    non-blocking consensus (NBX) algorithm: synchronous sends, then a
+    non-blocking barrier once they have all been matched. Fills recvCounts
+    (size entries) and recvOffsets (size+1 entries) and allocates rcv*/
+  template <typename T>
+  void SparseAlltoallv(const memory<T> snd,
+                       const memory<int> sendCounts,
+                       const memory<int> sendOffsets,
+                             memory<T> &rcv,
+                             memory<int> recvCounts,
+                             memory<int> recvOffsets) const {
+    MPI_Datatype type = mpiType<T>::getMpiType();
+
+    int Nsends=0;
+    for (int r=0;r<size();++r) if (sendCounts[r]) Nsends++;
+
+    memory<request_t> requests(Nsends);
+    Nsends=0;
+    for (int r=0;r<size();++r) {
+      if (sendCounts[r]==0) continue;
+      MPI_Issend(snd.ptr()+sendOffsets[r], sendCounts[r], type,
+                 r, sparseTag, comm(), requests.ptr()+Nsends++);
+    }
+
+    //receive whatever arrives until every rank's sends have been matched
+    std::map<int, memory<T>> msgs;
+    request_t barrier;
+    bool barrierActive=false;
+    bool done=false;
+    while (!done) {
+      int flag;
+      MPI_Status status;
+      MPI_Iprobe(MPI_ANY_SOURCE, sparseTag, comm(), &flag, &status);
+      if (flag) {
+        int cnt;
+        MPI_Get_count(&status, type, &cnt);
+        memory<T> buf(cnt);
+        MPI_Recv(buf.ptr(), cnt, type, status.MPI_SOURCE, sparseTag,
+                 comm(), MPI_STATUS_IGNORE);
+        msgs[status.MPI_SOURCE] = buf;
+      }
+
+      if (barrierActive) {
+        MPI_Test(&barrier, &flag, MPI_STATUS_IGNORE);
+        done = flag;
+      } else {
+        MPI_Testall(Nsends, requests.ptr(), &flag, MPI_STATUSES_IGNORE);
+        if (flag) {
+          MPI_Ibarrier(comm(), &barrier);
+          barrierActive = true;
+        }
+      }
+    }
+
+    for (int r=0;r<size();++r) recvCounts[r] = 0;
+    for (auto& msg : msgs) recvCounts[msg.first] = msg.second.length();
+
+    recvOffsets[0] = 0;
+    for (int r=0;r<size();++r)
+      recvOffsets[r+1] = recvOffsets[r]+recvCounts[r];
+
+    rcv.malloc(recvOffsets[size()]);
+    for (auto& msg : msgs)
+      rcv.copyFrom(msg.second, msg.second.length(), recvOffsets[msg.first]);
+
+    //a fast rank must not start its next exchange while a slow one is
+    // still probing for this one's tag
+    MPI_Barrier(comm());
+    mpiType<T>::freeMpiType(type);
+  }
+
+  /*libp::memory sparse alltoallv with a known pattern. Point-to-point
+    messages are posted only for the nonzero counts*/
+  template <typename T>
+  void NeighborAlltoallv(const memory<T> snd,
+                         const memory<int> sendCounts,
+                         const memory<int> sendOffsets,
+                               memory<T> rcv,
+                         const memory<int> recvCounts,
+                         const memory<int> recvOffsets) const {
+    MPI_Datatype type = mpiType<T>::getMpiType();
+
+    int Nrequests=0;
+    for (int r=0;r<size();++r) {
+      if (sendCounts[r]) Nrequests++;
+      if (recvCounts[r]) Nrequests++;
+    }
+
+    memory<request_t> requests(Nrequests);
+    Nrequests=0;
+    for (int r=0;r<size();++r) {
+      if (recvCounts[r]==0) continue;
+      MPI_Irecv(rcv.ptr()+recvOffsets[r], recvCounts[r], type,
+                r, sparseTag, comm(), requests.ptr()+Nrequests++);
+    }
+    for (int r=0;r<size();++r) {
+      if (sendCounts[r]==0) continue;
+      MPI_Isend(snd.ptr()+sendOffsets[r], sendCounts[r], type,
+                r, sparseTag, comm(), requests.ptr()+Nrequests++);
+    }
+    MPI_Waitall(Nrequests, requests.ptr(), MPI_STATUSES_IGNORE);
+    mpiType<T>::freeMpiType(type);
+  }
+
   void Wait(request_t &request) const;
   void Waitall(const int count, memory<request_t> &requests) const;
+  int Waitany(const int count, memory<request_t> &requests) const;
+  bool Testall(const int count, memory<request_t> &requests) const;
+
+  void TypeFree(datatype_t &type) const;
+
+  /*Poll for any message, driving MPI's progress engine*/
+  void Poll() const;
   void Barrier() const;
 
+  /*One-sided communication*/
+  using win_t = MPI_Win;
+  using group_t = MPI_Group;
+
+  /*libp::memory window creation (byte displacements)*/
+  template <template<typename> class mem, typename T>
+  void WinCreate(mem<T> m,
+                 win_t &win) const {
+    MPI_Win_create(m.ptr(), static_cast<MPI_Aint>(m.size()), 1,
+                   MPI_INFO_NULL, comm(), &win);
+  }
+  void WinFree(win_t &win) const;
+
+  /*Group of the listed ranks of this comm*/
+  group_t GroupIncl(const int count, const memory<int> ranks) const;
+  void GroupFree(group_t &group) const;
+
+  /*Rank in MPI_COMM_WORLD of each rank in this comm*/
+  memory<int> WorldRanks() const;
+
+  /*Post-Start-Complete-Wait synchronization*/
+  void WinPost(group_t group, win_t win) const;
+  void WinStart(group_t group, win_t win) const;
+  void WinComplete(win_t win) const;
+  void WinWait(win_t win) const;
+
+  /*Shared memory window allocation (byte displacements)*/
+  template <typename T>
+  T* WinAllocateShared(const size_t count,
+                       win_t &win) const {
+    T* ptr=nullptr;
+    MPI_Win_allocate_shared(static_cast<MPI_Aint>(count*sizeof(T)), 1,
+                            MPI_INFO_NULL, comm(), &ptr, &win);
+    return ptr;
+  }
+
+  /*Base address of another rank's segment of a shared window*/
+  template <typename T>
+  T* WinSharedQuery(const int r,
+                    win_t win) const {
+    MPI_Aint sz;
+    int dispUnit;
+    T* ptr=nullptr;
+    MPI_Win_shared_query(win, r, &sz, &dispUnit, &ptr);
+    return ptr;
+  }
+
+  /*Passive target synchronization*/
+  void WinLockAll(win_t win) const;
+  void WinUnlockAll(win_t win) const;
+  void WinSync(win_t win) const;
+
+  /*libp::memory put*/
+  template <template<typename> class mem, typename T>
+  void Put(const mem<T> m,
+           const int target,
+           const int count,
+           const size_t disp,
+           win_t win) const {
+    MPI_Datatype type = mpiType<T>::getMpiType();
+    MPI_Put(m.ptr(), count, type,
+            target, static_cast<MPI_Aint>(disp), count, type, win);
+    mpiType<T>::freeMpiType(type);
+  }
+
   static void GetProcessorName(char* name, int &namelen) {
     MPI_Get_processor_name(name,&namelen);
   }
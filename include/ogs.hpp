@@ -51,6 +51,25 @@ SOFTWARE.
   ogs::Unsigned can be passed to the 'Kind' parameter, which
   treats all id's as positive.
 
+  With ogs::Auto, the exchange method is chosen by benchmarking. An optional
+  list of exchange configurations {k, trans} can be passed after the platform,
+  in which case each configuration is tuned separately and operations are
+  dispatched to the exchange chosen for their (k, trans).
+
+  ogs::Hybrid sends pairwise messages to the neighbours sharing many nodes
+  with a rank and routes the remaining small messages through a crystal
+  router. ogs::Auto tunes the message size threshold between the two,
+  otherwise it is read from the "OGS HYBRID THRESHOLD" setting.
+
+  If the ids change, e.g. after elements migrate between processes, the
+  handle can be rebuilt with
+
+    ogs.Update(N, id, verbose);
+
+  which keeps what it can from the previous setup, including the exchange
+  methods selected by ogs::Auto. A halo_t set up from an ogs_t should be set
+  up from it again after the ogs_t is updated.
+
   When "ogs" is no longer needed, free it with
 
     ogs.Free();
@@ -139,6 +158,19 @@ SOFTWARE.
   calling GatherScatterFinish. The MPI communication will then take place while the
   user's local kernels execute to maximize the amount of communication hiding.
 
+  A handle can only have one Start/Finish pair in flight. To have several
+  operations in flight at once, the Async versions return a future,
+
+    ogs::ogsFuture_t fu = ogs.GatherScatterAsync(o_u, 1, ogs::Add, ogs::Sym);
+    ogs::ogsFuture_t fv = ogs.GatherScatterAsync(o_v, 1, ogs::Add, ogs::Sym);
+    ...
+    fv.wait();
+    fu.wait();
+
+  Each operation in flight runs on its own copy of the exchange, with private
+  buffers and message tags, from a ring kept by the handle. Futures may be
+  completed in any order, but every process must launch them in the same order.
+
   Finally, a specialized communcation object, named halo_t is provided. This
   object is analogous to an ogs_t object, where each group S_j has a sole
   "unflagged" (p,i) pair, as discussed above regarding the 'unique' parameter,
@@ -163,6 +195,15 @@ SOFTWARE.
   which has the effect of summing the entries in S_j and writing the result to
   the sole "unflagged" pair in S_j.
 
+  Several separate device arrays, possibly of different types, can be
+  exchanged together, e.g.,
+
+    std::vector<ogs::haloField_t> fields = {{o_p, 1}, {o_u, 3}, {o_flags, 1}};
+    halo.Exchange(fields);
+
+  The halo values of all fields are packed into a single buffer, so one
+  message is sent per neighbour regardless of the number of fields.
+
 */
 
 #ifndef OGS_HPP
@@ -194,11 +235,31 @@ typedef enum { Add, Mul, Max, Min} Op;
 typedef enum { Sym, NoTrans, Trans } Transpose;
 
 /* method switch */
-typedef enum { Auto, Pairwise, CrystalRouter, AllToAll} Method;
+typedef enum { Auto, Pairwise, CrystalRouter, AllToAll, RMA, SharedMemory, Hierarchical, Hybrid} Method;
 
 /* kind enum */
 typedef enum { Unsigned, Signed, Halo} Kind;
 
+/* exchange configuration (message width and transpose mode) to tune for */
+struct exchangeConfig_t {
+  int k;
+  Transpose trans;
+};
+
+/* a device array holding k values of its own type per node, for
+   aggregated halo exchanges. Stored as 32-bit words */
+struct haloField_t {
+  deviceMemory<int> o_v;
+  int k;
+
+  template<typename T>
+  haloField_t(deviceMemory<T> _o_v, const int _k=1):
+    o_v(_o_v), k(_k*static_cast<int>(sizeof(T)/sizeof(int))) {
+    static_assert(sizeof(T)%sizeof(int)==0,
+                  "haloField_t requires types made of whole 32-bit words");
+  }
+};
+
 } //namespace ogs
 
 } //namespace libp
@@ -212,6 +273,18 @@ namespace ogs {
 //pre-build kernels
 void InitializeKernels(platform_t& platform, const Type type, const Op op);
 
+//optional thread polling MPI while exchanges are in flight, so messages
+// progress during local work. Requires MPI_THREAD_MULTIPLE
+void StartProgressThread(comm_t comm);
+void StopProgressThread();
+
+//per-neighbour exchange statistics. When enabled, exchanges record the
+// messages sent to each peer and their Start-to-Finish and wait times.
+// ReportStats is collective, prints the min/avg/max over ranks, and writes
+// the rank-by-rank matrix of bytes sent as CSV if a filename is given
+void EnableStats(const bool enable=true);
+void ReportStats(comm_t comm, const std::string filename="");
+
 // OCCA Gather Scatter
 class ogs_t : public ogsBase_t {
 public:
@@ -225,7 +298,8 @@ public:
              const Method method,
              const bool _unique,
              const bool verbose,
-             platform_t& _platform);
+             platform_t& _platform,
+             const std::vector<exchangeConfig_t> configs={});
 
   void SetupGlobalToLocalMapping(memory<dlong> GlobalToLocal);
 
@@ -263,6 +337,12 @@ public:
                            const int k,
                            const Op op,
                            const Transpose trans);
+  // Asynchronous device buffer version returning a future
+  template<typename T>
+  ogsFuture_t GatherScatterAsync(deviceMemory<T> o_v,
+                                 const int k,
+                                 const Op op,
+                                 const Transpose trans);
 
   // Synchronous host versions
   template<typename T>
@@ -304,6 +384,13 @@ public:
                     const int k,
                     const Op op,
                     const Transpose trans);
+  // Asynchronous device buffer version returning a future
+  template<typename T>
+  ogsFuture_t GatherAsync(deviceMemory<T> o_gv,
+                          deviceMemory<T> o_v,
+                          const int k,
+                          const Op op,
+                          const Transpose trans);
 
   // Synchronous host versions
   template<typename T>
@@ -339,6 +426,12 @@ public:
                      deviceMemory<T> o_gv,
                      const int k,
                      const Transpose trans);
+  // Asynchronous device buffer version returning a future
+  template<typename T>
+  ogsFuture_t ScatterAsync(deviceMemory<T> o_v,
+                           deviceMemory<T> o_gv,
+                           const int k,
+                           const Transpose trans);
 
   friend class halo_t;
 };
@@ -350,6 +443,7 @@ public:
   ~halo_t()=default;
 
   bool gathered_halo=false;
+  bool reduced_precision=false;
   dlong Nhalo=0;
 
   void Setup(const dlong _N,
@@ -357,10 +451,18 @@ public:
              comm_t _comm,
              const Method method,
              const bool verbose,
-             platform_t& _platform);
+             platform_t& _platform,
+             const std::vector<exchangeConfig_t> configs={});
 
   void SetupFromGather(ogs_t& ogs);
 
+  void Update(const dlong _N,
+              memory<hlong> ids,
+              const bool verbose);
+
+  // Exchange double precision data as single precision on the wire
+  void SetReducedPrecision(const bool reduced);
+
   // Synchronous Host version
   template<typename T>
   void Exchange(memory<T> v, const int k);
@@ -377,6 +479,9 @@ public:
   void ExchangeStart (deviceMemory<T> o_v, const int k);
   template<typename T>
   void ExchangeFinish(deviceMemory<T> o_v, const int k);
+  // Asynchronous device buffer version returning a future
+  template<typename T>
+  ogsFuture_t ExchangeAsync(deviceMemory<T> o_v, const int k);
 
   // Synchronous Host version
   template<typename T>
@@ -394,8 +499,33 @@ public:
   void CombineStart (deviceMemory<T> o_v, const int k);
   template<typename T>
   void CombineFinish(deviceMemory<T> o_v, const int k);
+  // Asynchronous device buffer version returning a future
+  template<typename T>
+  ogsFuture_t CombineAsync(deviceMemory<T> o_v, const int k);
+
+  // Aggregated exchange of several device arrays in one message per peer
+  void Exchange(std::vector<haloField_t>& fields);
+  void ExchangeStart (std::vector<haloField_t>& fields);
+  void ExchangeFinish(std::vector<haloField_t>& fields);
+
+private:
+  //scratch for one field of an aggregated exchange
+  deviceMemory<int> o_fieldBuf;
+
+  //double precision staging for reduced precision exchanges
+  memory<double> haloDbl;
+  deviceMemory<double> o_haloDbl;
+
+  void ReducedExchangeStart (memory<double> v, const int k);
+  void ReducedExchangeFinish(memory<double> v, const int k);
+  void ReducedExchangeStart (deviceMemory<double> o_v, const int k);
+  void ReducedExchangeFinish(deviceMemory<double> o_v, const int k);
 };
 
 } //namespace ogs
+
+void ogsAddSettings(settings_t& settings);
+void ogsReportSettings(settings_t& settings);
+
 } //namespace libp
 #endif
@@ -28,6 +28,8 @@ SOFTWARE.
 #define OGSBASE_HPP
 
 #include "ogs.hpp"
+#include "timer.hpp"
+#include <functional>
 
 namespace libp {
 
@@ -37,10 +39,81 @@ namespace ogs {
 class ogsOperator_t;
 class ogsFusedOperator_t;
 class ogsExchange_t;
+class ogsTuning_t;
 
 struct parallelNode_t;
 
 class halo_t;
+class ogsBase_t;
+
+//an exchange with private buffers, so several asynchronous operations on
+// one handle can be in flight at once
+struct exchangeSlot_t {
+  std::shared_ptr<ogsExchange_t> source;   //exchange selected when this slot was set up
+  std::shared_ptr<ogsExchange_t> exchange; //private copy of source, or source itself
+  streamTag_t dataTag;
+  std::function<void()> finish;
+  int tagOffset=0;
+  uint64_t ticket=0;
+  bool busy=false;
+  ogsBase_t* owner=nullptr; //handle which launched the operation
+
+  void Complete();
+};
+
+//ring of exchange slots, shared by an ogs_t and the halos built from it
+// since they share its exchanges. Tickets are counted over the whole ring,
+// so operations of either handle get distinct message tags
+struct slotRing_t {
+  std::vector<std::shared_ptr<exchangeSlot_t>> slots;
+  uint64_t Nlaunched=0;
+};
+
+//handle to an asynchronous operation in flight. wait() completes it, and
+// test() advances it and completes it if it would not block. Exchanges
+// which only communicate in their Finish are completed by wait()
+class ogsFuture_t {
+public:
+  ogsFuture_t()=default;
+
+  void wait();
+  bool test();
+
+private:
+  std::shared_ptr<exchangeSlot_t> slot;
+  uint64_t ticket=0;
+
+  ogsFuture_t(std::shared_ptr<exchangeSlot_t> _slot):
+    slot(_slot), ticket(_slot->ticket) {}
+
+  friend class ogsBase_t;
+};
+
+//mark an exchange as in flight for the progress thread
+void ProgressBegin();
+void ProgressEnd();
+
+//times the enclosing exchange Start or Finish call for online re-tuning,
+// and marks the exchange in flight from Start until Finish returns, for
+// the progress thread and the exchange statistics
+class exchangeTimer_t {
+public:
+  exchangeTimer_t(std::shared_ptr<ogsTuning_t> _tuning,
+                  std::shared_ptr<ogsExchange_t> _exchange,
+                  const int _config,
+                  const bool _finish);
+  ~exchangeTimer_t();
+
+  exchangeTimer_t(const exchangeTimer_t&)=delete;
+  exchangeTimer_t& operator=(const exchangeTimer_t&)=delete;
+
+private:
+  std::shared_ptr<ogsTuning_t> tuning;
+  std::shared_ptr<ogsExchange_t> exchange;
+  int config;
+  bool finish;
+  timePoint_t start;
+};
 
 class ogsBase_t {
 public:
@@ -61,7 +134,10 @@ public:
   bool unique=false;
   bool gather_defined=false;
 
-  static stream_t dataStream;
+  //each handle stages its host exchanges on its own stream, and
+  // tags the staging copy so Finish only waits on that copy
+  stream_t dataStream;
+  streamTag_t dataTag;
 
   ogsBase_t()=default;
   virtual ~ogsBase_t()=default;
@@ -73,20 +149,67 @@ public:
                       const Method method,
                       const bool _unique,
                       const bool verbose,
-                      platform_t& _platform);
+                      platform_t& _platform,
+                      const std::vector<exchangeConfig_t> configs={});
   void Free();
 
+  //Rebuild for a new id list, e.g. after elements migrate between ranks.
+  // Nothing is rebuilt if no rank's ids changed. Otherwise the shared nodes
+  // are found again, local gather operators are kept on ranks whose node
+  // list is unchanged, and the exchange methods chosen at setup are rebuilt
+  // for the new pattern without re-tuning
+  void Update(const dlong _N,
+              memory<hlong> ids,
+              const bool verbose);
+
+  //polling hook to advance an exchange between its Start and Finish
+  void Progress();
+
 protected:
   std::shared_ptr<ogsOperator_t> gatherLocal;
   std::shared_ptr<ogsOperator_t> gatherHalo;
   std::shared_ptr<ogsExchange_t> exchange;
 
+  //per-configuration exchanges, filled by AutoSetup
+  std::shared_ptr<ogsTuning_t> tuning;
+
+  //what Update needs from the last setup
+  Method setupMethod=Auto;
+  uint64_t idsHash=0;
+  uint64_t localHash=0;
+  std::vector<bool> ownerFlags;
+
+  //ring of exchange slots for asynchronous operations
+  std::shared_ptr<slotRing_t> ring = std::make_shared<slotRing_t>();
+  exchangeSlot_t* activeSlot=nullptr;
+
+  ogsFuture_t Launch(const std::function<void()>& start,
+                     const std::function<void()>& finish);
+  void RunInSlot(exchangeSlot_t& slot, const std::function<void()>& op);
+  void DrainSlots(const std::shared_ptr<ogsExchange_t>& ex);
+  void DrainAllSlots();
+
   void AssertGatherDefined();
+  exchangeTimer_t SelectExchange(const int k,
+                                 const Transpose trans,
+                                 const bool finish=false);
 
 private:
-  void FindSharedNodes(const dlong Nids,
-                       memory<parallelNode_t> &nodes,
-                       const int verbose);
+  void BuildOperators(memory<hlong> ids,
+                      const Method method,
+                      const std::vector<exchangeConfig_t>& configs,
+                      const bool verbose,
+                      const bool update);
+
+  dlong FindSharedNodes(const dlong Nids,
+                        memory<parallelNode_t> &nodes,
+                        const int verbose);
+
+  void AssignOwners(const dlong recvN,
+                    memory<parallelNode_t> &recvNodes,
+                    const memory<int> sendCounts,
+                    const memory<int> recvCounts,
+                    const int verbose);
 
   void ConstructSharedNodes(const dlong Nids,
                            memory<parallelNode_t> &nodes,
@@ -97,12 +220,22 @@ private:
   void LocalUnsignedSetup(const dlong Nids, memory<parallelNode_t> &nodes);
   void LocalHaloSetup(const dlong Nids, memory<parallelNode_t> &nodes);
 
-  ogsExchange_t* AutoSetup(dlong Nshared,
+  void AutoSetup(dlong Nshared,
+                 memory<parallelNode_t> &sharedNodes,
+                 ogsOperator_t& gatherHalo,
+                 comm_t _comm,
+                 platform_t &_platform,
+                 const std::vector<exchangeConfig_t>& configs,
+                 const int verbose);
+
+  void RebuildExchanges(dlong Nshared,
+                        memory<parallelNode_t> &sharedNodes,
+                        ogsOperator_t& gatherHalo);
+
+  void BuildTunedExchanges(dlong Nshared,
                            memory<parallelNode_t> &sharedNodes,
                            ogsOperator_t& gatherHalo,
-                           comm_t _comm,
-                           platform_t &_platform,
-                           const int verbose);
+                           const int Npool);
 };
 
 } //namespace ogs
@@ -29,6 +29,8 @@ SOFTWARE.
 
 #include "ogs.hpp"
 #include "ogs/ogsOperator.hpp"
+#include <map>
+#include <tuple>
 
 namespace libp {
 
@@ -48,6 +50,10 @@ public:
 
   stream_t dataStream;
   static kernel_t extractKernel[4];
+  static kernel_t downConvertKernel;
+  static kernel_t upConvertKernel;
+  static kernel_t packFieldsKernel;
+  static kernel_t unpackFieldsKernel;
 
 #ifdef GPU_AWARE_MPI
   bool gpu_aware=true;
@@ -83,8 +89,43 @@ public:
   virtual void Finish(deviceMemory<int> &buf,const int k,const Op op,const Transpose trans)=0;
   virtual void Finish(deviceMemory<long long int> &buf,const int k,const Op op,const Transpose trans)=0;
 
+  //pipelined host staging of a device buffer when MPI is not gpu-aware.
+  // Exchanges which can stage per peer set staged and override these
+  bool staged=false;
+
+  virtual void StagedStart(deviceMemory<float> &buf,const int k,const Op op,const Transpose trans) {}
+  virtual void StagedStart(deviceMemory<double> &buf,const int k,const Op op,const Transpose trans) {}
+  virtual void StagedStart(deviceMemory<int> &buf,const int k,const Op op,const Transpose trans) {}
+  virtual void StagedStart(deviceMemory<long long int> &buf,const int k,const Op op,const Transpose trans) {}
+  virtual void StagedFinish(deviceMemory<float> &buf,const int k,const Op op,const Transpose trans) {}
+  virtual void StagedFinish(deviceMemory<double> &buf,const int k,const Op op,const Transpose trans) {}
+  virtual void StagedFinish(deviceMemory<int> &buf,const int k,const Op op,const Transpose trans) {}
+  virtual void StagedFinish(deviceMemory<long long int> &buf,const int k,const Op op,const Transpose trans) {}
+
   virtual void AllocBuffer(size_t Nbytes)=0;
 
+  //polling hook to advance an exchange between Start and Finish
+  virtual void Progress() {}
+
+  //true if Finish would not block on communication
+  virtual bool Ready() { return false; }
+
+  //offset added to message tags, so copies of an exchange can be in flight together
+  int tagOffset=0;
+
+  //a copy of this exchange sharing its communication pattern but with
+  // private buffers, or nullptr if copies can not be made locally
+  virtual ogsExchange_t* Clone() { return nullptr; }
+
+  //per-neighbour message statistics, recorded only when enabled with EnableStats
+  void RecordSend(const int peer, const size_t bytes);
+  void RecordWait(const timePoint_t start);
+  void RecordStart();
+  void RecordFinish();
+
+  timePoint_t statsStart;
+  memory<int> worldRanks;
+
   friend void InitializeKernels(platform_t& platform, const Type type, const Op op);
 };
 
@@ -170,7 +211,7 @@ public:
 
 //MPI communcation via pairwise send/recvs
 class ogsPairwise_t: public ogsExchange_t {
-private:
+protected:
 
   dlong NsendN=0, NsendT=0;
   memory<dlong> sendIdsN, sendIdsT;
@@ -194,6 +235,28 @@ private:
   memory<int> recvOffsetsT;
   memory<comm_t::request_t> requests;
 
+  //completion tags of the per-peer staging copies
+  memory<streamTag_t> sendTags;
+
+  //requests posted by Start and not yet waited on by Finish, and whether
+  // Ready has already completed them all
+  int Nposted=0;
+  bool posted=false;
+  bool completed=false;
+
+  //per-peer derived datatypes describing the send lists over the halo
+  // buffer, so host exchanges can send without an explicit extract
+  struct sendTypes_t {
+    comm_t comm;
+    memory<comm_t::datatype_t> types;
+    memory<int> useType; //1 if the datatype packed faster than extract for this peer
+    ~sendTypes_t();
+  };
+  std::map<std::tuple<int,int,int>, std::shared_ptr<sendTypes_t>> sendTypeCache;
+
+  template<typename T>
+  sendTypes_t& SendTypes(pinnedMemory<T> &buf, const int k, const Transpose trans);
+
 public:
   ogsPairwise_t(dlong Nshared,
                memory<parallelNode_t> &sharedNodes,
@@ -244,6 +307,253 @@ public:
   virtual void Finish(deviceMemory<int> &buf,const int k,const Op op,const Transpose trans);
   virtual void Finish(deviceMemory<long long int> &buf,const int k,const Op op,const Transpose trans);
 
+  template<typename T>
+  void StagedStart(deviceMemory<T> &buf,
+                   const int k,
+                   const Op op,
+                   const Transpose trans);
+
+  template<typename T>
+  void StagedFinish(deviceMemory<T> &buf,
+                    const int k,
+                    const Op op,
+                    const Transpose trans);
+
+  virtual void StagedStart(deviceMemory<float> &buf,const int k,const Op op,const Transpose trans);
+  virtual void StagedStart(deviceMemory<double> &buf,const int k,const Op op,const Transpose trans);
+  virtual void StagedStart(deviceMemory<int> &buf,const int k,const Op op,const Transpose trans);
+  virtual void StagedStart(deviceMemory<long long int> &buf,const int k,const Op op,const Transpose trans);
+  virtual void StagedFinish(deviceMemory<float> &buf,const int k,const Op op,const Transpose trans);
+  virtual void StagedFinish(deviceMemory<double> &buf,const int k,const Op op,const Transpose trans);
+  virtual void StagedFinish(deviceMemory<int> &buf,const int k,const Op op,const Transpose trans);
+  virtual void StagedFinish(deviceMemory<long long int> &buf,const int k,const Op op,const Transpose trans);
+
+  virtual void AllocBuffer(size_t Nbytes);
+
+  virtual bool Ready();
+
+  virtual ogsExchange_t* Clone();
+};
+
+//MPI communcation via one-sided puts into pre-exposed windows
+class ogsRMA_t: public ogsPairwise_t {
+private:
+
+  //displacements (in entries) of our data in each peer's window
+  memory<int> putDispsN;
+  memory<int> putDispsT;
+
+  //ranks which put into our window, and ranks we put into
+  comm_t::group_t originGroupN, originGroupT;
+  comm_t::group_t targetGroupN, targetGroupT;
+
+  //windows exposing the host and device workspaces
+  comm_t::win_t h_win, o_win;
+  bool h_winCreated=false, o_winCreated=false;
+  size_t NbytesWin=0;
+
+  void FreeWindows();
+
+public:
+  ogsRMA_t(dlong Nshared,
+           memory<parallelNode_t> &sharedNodes,
+           ogsOperator_t &gatherHalo,
+           stream_t _dataStream,
+           comm_t _comm,
+           platform_t &_platform);
+  ~ogsRMA_t();
+
+  template<typename T>
+  void Start(pinnedMemory<T> &buf,
+                const int k,
+                const Op op,
+                const Transpose trans);
+
+  template<typename T>
+  void Finish(pinnedMemory<T> &buf,
+                const int k,
+                const Op op,
+                const Transpose trans);
+
+  virtual void Start(pinnedMemory<float> &buf,const int k,const Op op,const Transpose trans);
+  virtual void Start(pinnedMemory<double> &buf,const int k,const Op op,const Transpose trans);
+  virtual void Start(pinnedMemory<int> &buf,const int k,const Op op,const Transpose trans);
+  virtual void Start(pinnedMemory<long long int> &buf,const int k,const Op op,const Transpose trans);
+  virtual void Finish(pinnedMemory<float> &buf,const int k,const Op op,const Transpose trans);
+  virtual void Finish(pinnedMemory<double> &buf,const int k,const Op op,const Transpose trans);
+  virtual void Finish(pinnedMemory<int> &buf,const int k,const Op op,const Transpose trans);
+  virtual void Finish(pinnedMemory<long long int> &buf,const int k,const Op op,const Transpose trans);
+
+  template<typename T>
+  void Start(deviceMemory<T> &buf,
+                const int k,
+                const Op op,
+                const Transpose trans);
+
+  template<typename T>
+  void Finish(deviceMemory<T> &buf,
+                const int k,
+                const Op op,
+                const Transpose trans);
+
+  virtual void Start(deviceMemory<float> &buf,const int k,const Op op,const Transpose trans);
+  virtual void Start(deviceMemory<double> &buf,const int k,const Op op,const Transpose trans);
+  virtual void Start(deviceMemory<int> &buf,const int k,const Op op,const Transpose trans);
+  virtual void Start(deviceMemory<long long int> &buf,const int k,const Op op,const Transpose trans);
+  virtual void Finish(deviceMemory<float> &buf,const int k,const Op op,const Transpose trans);
+  virtual void Finish(deviceMemory<double> &buf,const int k,const Op op,const Transpose trans);
+  virtual void Finish(deviceMemory<int> &buf,const int k,const Op op,const Transpose trans);
+  virtual void Finish(deviceMemory<long long int> &buf,const int k,const Op op,const Transpose trans);
+
+  virtual void AllocBuffer(size_t Nbytes);
+
+  //windows are created collectively, so RMA exchanges are not copied
+  virtual ogsExchange_t* Clone() { return nullptr; }
+};
+
+//Exchange via shared memory with node-local peers, and MPI otherwise
+class ogsSharedMemory_t: public ogsPairwise_t {
+private:
+
+  comm_t nodeComm;
+  int nodeRank=0, nodeSize=1;
+
+  //node rank of each send/recv peer (-1 when off-node)
+  memory<int> nodeSendRanksN, nodeSendRanksT;
+  memory<int> nodeRecvRanksN, nodeRecvRanksT;
+
+  //offset of our data in each source's send buffer
+  memory<int> peerOffsetsN, peerOffsetsT;
+
+  //shared segment: sequence flags followed by our send buffer
+  comm_t::win_t shmWin;
+  bool shmWinCreated=false;
+  size_t NbytesShm=0, headerBytes=0;
+  memory<char*> segments;
+
+  hlong seq=0;
+  memory<hlong> lastSent;
+  int Nrequests=0;
+
+  void FreeSegment();
+
+public:
+  ogsSharedMemory_t(dlong Nshared,
+                    memory<parallelNode_t> &sharedNodes,
+                    ogsOperator_t &gatherHalo,
+                    stream_t _dataStream,
+                    comm_t _comm,
+                    platform_t &_platform);
+  ~ogsSharedMemory_t();
+
+  //GPU-aware exchanges are left to MPI's own intra-node transport
+  using ogsPairwise_t::Start;
+  using ogsPairwise_t::Finish;
+
+  template<typename T>
+  void Start(pinnedMemory<T> &buf,
+                const int k,
+                const Op op,
+                const Transpose trans);
+
+  template<typename T>
+  void Finish(pinnedMemory<T> &buf,
+                const int k,
+                const Op op,
+                const Transpose trans);
+
+  virtual void Start(pinnedMemory<float> &buf,const int k,const Op op,const Transpose trans);
+  virtual void Start(pinnedMemory<double> &buf,const int k,const Op op,const Transpose trans);
+  virtual void Start(pinnedMemory<int> &buf,const int k,const Op op,const Transpose trans);
+  virtual void Start(pinnedMemory<long long int> &buf,const int k,const Op op,const Transpose trans);
+  virtual void Finish(pinnedMemory<float> &buf,const int k,const Op op,const Transpose trans);
+  virtual void Finish(pinnedMemory<double> &buf,const int k,const Op op,const Transpose trans);
+  virtual void Finish(pinnedMemory<int> &buf,const int k,const Op op,const Transpose trans);
+  virtual void Finish(pinnedMemory<long long int> &buf,const int k,const Op op,const Transpose trans);
+
+  virtual void AllocBuffer(size_t Nbytes);
+
+  //windows are created collectively, so shared memory exchanges are not copied
+  virtual ogsExchange_t* Clone() { return nullptr; }
+};
+
+//Two-level exchange, aggregating halo data at a leader rank on each node
+class ogsHierarchical_t: public ogsExchange_t {
+private:
+
+  comm_t nodeComm;
+  comm_t leaderComm;
+  int nodeRank=0, nodeSize=1;
+
+  //halo rows gathered from each rank on the node
+  dlong NnodeCols=0;
+  memory<int> nodeCounts, nodeOffsets;
+  memory<int> nodeCountsK, nodeOffsetsK;
+  memory<int> nodeRanks;
+
+  //leader: reduce the gathered rows to one row per distinct id
+  dlong NnodeRows=0;
+  ogsOperator_t nodeGather;
+
+  //leader: exchange the reduced rows between nodes
+  ogs_t leaderOgs;
+
+  pinnedMemory<char> h_nodespace;
+  memory<char> nodeRowspace;
+
+  //node-level gather posted in Start
+  comm_t::request_t nodeRequest;
+
+public:
+  ogsHierarchical_t(dlong Nshared,
+                    memory<parallelNode_t> &sharedNodes,
+                    ogsOperator_t &gatherHalo,
+                    stream_t _dataStream,
+                    comm_t _comm,
+                    platform_t &_platform);
+
+  template<typename T>
+  void Start(pinnedMemory<T> &buf,
+                const int k,
+                const Op op,
+                const Transpose trans);
+
+  template<typename T>
+  void Finish(pinnedMemory<T> &buf,
+                const int k,
+                const Op op,
+                const Transpose trans);
+
+  virtual void Start(pinnedMemory<float> &buf,const int k,const Op op,const Transpose trans);
+  virtual void Start(pinnedMemory<double> &buf,const int k,const Op op,const Transpose trans);
+  virtual void Start(pinnedMemory<int> &buf,const int k,const Op op,const Transpose trans);
+  virtual void Start(pinnedMemory<long long int> &buf,const int k,const Op op,const Transpose trans);
+  virtual void Finish(pinnedMemory<float> &buf,const int k,const Op op,const Transpose trans);
+  virtual void Finish(pinnedMemory<double> &buf,const int k,const Op op,const Transpose trans);
+  virtual void Finish(pinnedMemory<int> &buf,const int k,const Op op,const Transpose trans);
+  virtual void Finish(pinnedMemory<long long int> &buf,const int k,const Op op,const Transpose trans);
+
+  template<typename T>
+  void Start(deviceMemory<T> &buf,
+                const int k,
+                const Op op,
+                const Transpose trans);
+
+  template<typename T>
+  void Finish(deviceMemory<T> &buf,
+                const int k,
+                const Op op,
+                const Transpose trans);
+
+  virtual void Start(deviceMemory<float> &buf,const int k,const Op op,const Transpose trans);
+  virtual void Start(deviceMemory<double> &buf,const int k,const Op op,const Transpose trans);
+  virtual void Start(deviceMemory<int> &buf,const int k,const Op op,const Transpose trans);
+  virtual void Start(deviceMemory<long long int> &buf,const int k,const Op op,const Transpose trans);
+  virtual void Finish(deviceMemory<float> &buf,const int k,const Op op,const Transpose trans);
+  virtual void Finish(deviceMemory<double> &buf,const int k,const Op op,const Transpose trans);
+  virtual void Finish(deviceMemory<int> &buf,const int k,const Op op,const Transpose trans);
+  virtual void Finish(deviceMemory<long long int> &buf,const int k,const Op op,const Transpose trans);
+
   virtual void AllocBuffer(size_t Nbytes);
 };
 
@@ -276,6 +586,26 @@ private:
 
   int NsendMax=0, NrecvMax=0;
 
+  //state of the exchange in flight, so levels can be advanced by
+  // polling hooks between Start and Finish
+  int level=0;
+  bool posted=false;
+  bool inFlight=false;
+  bool onDevice=false;
+  Type typeFlight=Float;
+  int kFlight=1;
+  Op opFlight=Add;
+  Transpose transFlight=Sym;
+
+  memory<crLevel> Levels() { return (transFlight==NoTrans) ? levelsN : levelsT; }
+
+  template<typename T> void HostPost(const int l);
+  template<typename T> void HostComplete(const int l);
+  template<typename T> void HostProgress();
+  template<typename T> void DevicePost(const int l);
+  template<typename T> void DeviceComplete(const int l);
+  template<typename T> void DeviceProgress();
+
 public:
   ogsCrystalRouter_t(dlong Nshared,
                    memory<parallelNode_t> &sharedNodes,
@@ -327,6 +657,131 @@ public:
   virtual void Finish(deviceMemory<long long int> &buf,const int k,const Op op,const Transpose trans);
 
   virtual void AllocBuffer(size_t Nbytes);
+
+  virtual bool Ready();
+
+  virtual ogsExchange_t* Clone();
+
+  virtual void Progress();
+};
+
+//MPI communcation split by message size. Peers sharing at least threshold
+// nodes with this rank are sent pairwise messages, and the remaining small
+// messages are routed through the levels of a crystal router
+class ogsHybrid_t: public ogsPairwise_t {
+private:
+
+  dlong threshold=0;
+
+  //halo rows shared with at least one small peer, and the router exchanging them
+  dlong NlightHalo=0;
+  memory<dlong> lightIds;
+  std::shared_ptr<ogsCrystalRouter_t> router;
+
+  static dlong PartitionPeers(dlong Nshared,
+                              memory<parallelNode_t> &sharedNodes,
+                              const dlong threshold,
+                              comm_t comm);
+
+public:
+  ogsHybrid_t(dlong Nshared,
+              memory<parallelNode_t> &sharedNodes,
+              ogsOperator_t &gatherHalo,
+              stream_t _dataStream,
+              comm_t _comm,
+              platform_t &_platform,
+              const dlong _threshold);
+
+  template<typename T>
+  void Start(pinnedMemory<T> &buf,
+                const int k,
+                const Op op,
+                const Transpose trans);
+
+  template<typename T>
+  void Finish(pinnedMemory<T> &buf,
+                const int k,
+                const Op op,
+                const Transpose trans);
+
+  virtual void Start(pinnedMemory<float> &buf,const int k,const Op op,const Transpose trans);
+  virtual void Start(pinnedMemory<double> &buf,const int k,const Op op,const Transpose trans);
+  virtual void Start(pinnedMemory<int> &buf,const int k,const Op op,const Transpose trans);
+  virtual void Start(pinnedMemory<long long int> &buf,const int k,const Op op,const Transpose trans);
+  virtual void Finish(pinnedMemory<float> &buf,const int k,const Op op,const Transpose trans);
+  virtual void Finish(pinnedMemory<double> &buf,const int k,const Op op,const Transpose trans);
+  virtual void Finish(pinnedMemory<int> &buf,const int k,const Op op,const Transpose trans);
+  virtual void Finish(pinnedMemory<long long int> &buf,const int k,const Op op,const Transpose trans);
+
+  template<typename T>
+  void Start(deviceMemory<T> &buf,
+                const int k,
+                const Op op,
+                const Transpose trans);
+
+  template<typename T>
+  void Finish(deviceMemory<T> &buf,
+                const int k,
+                const Op op,
+                const Transpose trans);
+
+  virtual void Start(deviceMemory<float> &buf,const int k,const Op op,const Transpose trans);
+  virtual void Start(deviceMemory<double> &buf,const int k,const Op op,const Transpose trans);
+  virtual void Start(deviceMemory<int> &buf,const int k,const Op op,const Transpose trans);
+  virtual void Start(deviceMemory<long long int> &buf,const int k,const Op op,const Transpose trans);
+  virtual void Finish(deviceMemory<float> &buf,const int k,const Op op,const Transpose trans);
+  virtual void Finish(deviceMemory<double> &buf,const int k,const Op op,const Transpose trans);
+  virtual void Finish(deviceMemory<int> &buf,const int k,const Op op,const Transpose trans);
+  virtual void Finish(deviceMemory<long long int> &buf,const int k,const Op op,const Transpose trans);
+
+  virtual void AllocBuffer(size_t Nbytes);
+
+  virtual bool Ready();
+
+  virtual ogsExchange_t* Clone();
+
+  virtual void Progress();
+
+  dlong Threshold() const { return threshold; }
+};
+
+//Exchanges tuned per configuration, with live timing statistics and a pool
+// of alternative exchanges for online re-tuning. Shared by an ogs_t and the
+// halos built from it.
+class ogsTuning_t {
+public:
+  std::vector<exchangeConfig_t> configs;
+
+  std::vector<std::shared_ptr<ogsExchange_t>> exchanges;
+  std::vector<Method> methods;
+  std::vector<bool> gpu_aware;
+  std::vector<dlong> thresholds; //message size threshold of Hybrid exchanges
+
+  //alternatives kept alive for re-trials
+  std::vector<std::vector<std::shared_ptr<ogsExchange_t>>> pool;
+  std::vector<std::vector<Method>> poolMethods;
+  std::vector<std::vector<bool>> poolGpuAware;
+  std::vector<std::vector<dlong>> poolThresholds;
+
+  //timing statistics since the last re-trial
+  std::vector<int> Nstarts;
+  std::vector<int> Ncalls;
+  std::vector<double> elapsed;
+  std::vector<int> Nwins;   //consecutive re-trials won by the same alternative
+  std::vector<int> winner;  //alternative which won the last re-trial (-1 if none)
+
+  int interval=0; //exchanges between re-trials (0 disables re-tuning)
+  int verbose=0;
+
+  static constexpr int Npool=2;        //alternatives kept per configuration
+  static constexpr int Nconsistent=3;  //re-trials an alternative must win to switch
+  static constexpr double margin=0.1;  //relative speedup an alternative must show
+
+  void Resize(const int Nconfigs);
+  void Record(const int c, const double time, const bool finish);
+  void Retune(const int c);
+
+  bool RetuneDue(const int c) const { return interval>0 && Nstarts[c]>=interval; }
 };
 
 } //namespace ogs
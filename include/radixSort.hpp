@@ -0,0 +1,194 @@
+/*
+
+The MIT License (MIT)
+
+Copyright (c) 2017-2022 Tim Warburton, Noel Chalmers, Jesse Chan, Ali Karakus
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+*/
+
+#ifndef LIBP_RADIXSORT_HPP
+#define LIBP_RADIXSORT_HPP
+
+#include "core.hpp"
+#include <cstdint>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+namespace libp {
+
+/*Parallel LSD radix sort. Records are not moved while sorting. Instead a
+  permutation is sorted by unsigned integer keys extracted from the
+  records, one byte per pass, and then applied to the records once.*/
+
+/*Stable sort of the permutation perm[0:N] by key(perm[n]). Digits on which
+  all the keys agree are skipped, so small key ranges take few passes.
+  Applying this from the least to the most significant key gives a
+  lexicographic sort.*/
+template<typename Key>
+void RadixSortPermutation(const dlong N, memory<dlong> perm, Key key) {
+  if (N<2) return;
+
+  constexpr int radixBits = 8;
+  constexpr int Nbuckets = 1<<radixBits;
+  constexpr uint64_t mask = Nbuckets-1;
+
+  memory<uint64_t> keys(N), keysTmp(N);
+  memory<dlong> p(perm), pTmp(N);
+
+  //extract the keys once, and find which bits vary
+  const uint64_t key0 = key(perm[0]);
+  uint64_t diff=0;
+  #pragma omp parallel for reduction(|:diff)
+  for (dlong n=0;n<N;++n) {
+    keys[n] = key(perm[n]);
+    diff |= keys[n]^key0;
+  }
+
+#ifdef _OPENMP
+  const int maxThreads = omp_get_max_threads();
+#else
+  const int maxThreads = 1;
+#endif
+  memory<dlong> counts(maxThreads*Nbuckets);
+
+  for (int shift=0;shift<64;shift+=radixBits) {
+    if (((diff>>shift)&mask)==0) continue; //all keys agree on this digit
+
+    #pragma omp parallel
+    {
+#ifdef _OPENMP
+      const int Nthreads = omp_get_num_threads();
+      const int t = omp_get_thread_num();
+#else
+      const int Nthreads = 1;
+      const int t = 0;
+#endif
+      //split in size_t, N*Nthreads can overflow dlong
+      const dlong start = static_cast<dlong>((static_cast<size_t>(N)*t)/Nthreads);
+      const dlong end   = static_cast<dlong>((static_cast<size_t>(N)*(t+1))/Nthreads);
+
+      dlong *cnt = counts.ptr()+t*Nbuckets;
+      for (int b=0;b<Nbuckets;++b) cnt[b]=0;
+      for (dlong n=start;n<end;++n) cnt[(keys[n]>>shift)&mask]++;
+
+      #pragma omp barrier
+      #pragma omp single
+      {
+        //scan in (digit, thread) order so equal digits keep their order
+        dlong offset=0;
+        for (int b=0;b<Nbuckets;++b) {
+          for (int s=0;s<Nthreads;++s) {
+            const dlong c = counts[s*Nbuckets+b];
+            counts[s*Nbuckets+b] = offset;
+            offset += c;
+          }
+        }
+      }
+
+      for (dlong n=start;n<end;++n) {
+        const dlong id = cnt[(keys[n]>>shift)&mask]++;
+        keysTmp[id] = keys[n];
+        pTmp[id] = p[n];
+      }
+    }
+
+    std::swap(keys, keysTmp);
+    std::swap(p, pTmp);
+  }
+
+  //an odd number of passes leaves the result in the scratch buffer
+  if (p.ptr()!=perm.ptr()) {
+    #pragma omp parallel for
+    for (dlong n=0;n<N;++n) perm[n] = p[n];
+  }
+}
+
+/*Reorder the records so that A[n] <- A[perm[n]]*/
+template<typename T>
+void ApplyPermutation(const dlong N, memory<T> A, const memory<dlong> perm) {
+  memory<T> B(N);
+
+  #pragma omp parallel for
+  for (dlong n=0;n<N;++n) B[n] = A[perm[n]];
+
+  #pragma omp parallel for
+  for (dlong n=0;n<N;++n) A[n] = B[n];
+}
+
+template<typename T>
+void RadixSortKeys(const dlong N, memory<T> A, memory<dlong> perm) {}
+
+template<typename T, typename Key, typename... Keys>
+void RadixSortKeys(const dlong N, memory<T> A, memory<dlong> perm,
+                   Key key, Keys... keys) {
+  //less significant keys go first
+  RadixSortKeys(N, A, perm, keys...);
+  RadixSortPermutation(N, perm,
+                       [&](const dlong n) { return key(A[n]); });
+}
+
+/*Stable sort of A[0:N] by the keys, most significant key first. Each key
+  maps a record to an unsigned integer*/
+template<typename T, typename... Keys>
+void RadixSort(const dlong N, memory<T> A, Keys... keys) {
+  if (N<2) return;
+
+  memory<dlong> perm(N);
+  #pragma omp parallel for
+  for (dlong n=0;n<N;++n) perm[n] = n;
+
+  RadixSortKeys(N, A, perm, keys...);
+  ApplyPermutation(N, A, perm);
+}
+
+/*Lexicographic sort of A[0:N] by the first Nverts entries of each record's
+  vertex list v. The first vertex nearly decides the order, so radix sort
+  on it, then finish the short runs of records sharing a first vertex with
+  a comparison sort*/
+template<typename T>
+void RadixSortByVertices(const dlong N, memory<T> A, const int Nverts) {
+  if (N<2) return;
+
+  RadixSort(N, A,
+            [](const T& a) { return static_cast<uint64_t>(a.v[0]); });
+
+  dlong Nruns=0;
+  memory<dlong> runStarts(N+1);
+  runStarts[Nruns++] = 0;
+  for (dlong n=1;n<N;++n)
+    if (A[n].v[0]!=A[n-1].v[0]) runStarts[Nruns++] = n;
+  runStarts[Nruns] = N;
+
+  #pragma omp parallel for schedule(dynamic, 1024)
+  for (dlong r=0;r<Nruns;++r) {
+    if (runStarts[r+1]-runStarts[r]<2) continue;
+    std::sort(A.ptr()+runStarts[r], A.ptr()+runStarts[r+1],
+              [&](const T& a, const T& b) {
+                return std::lexicographical_compare(a.v+1, a.v+Nverts,
+                                                    b.v+1, b.v+Nverts);
+              });
+  }
+}
+
+} //namespace libp
+
+#endif
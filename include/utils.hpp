@@ -45,6 +45,7 @@ using properties_t = occa::json;
 using device_t = occa::device;
 using kernel_t = occa::kernel;
 using stream_t = occa::stream;
+using streamTag_t = occa::streamTag;
 
 //error codes
 #define LIBP_SUCCESS 0
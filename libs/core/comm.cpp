@@ -29,9 +29,22 @@ SOFTWARE.
 namespace libp {
 
 /*Static MPI_Init and MPI_Finalize*/
-void comm_t::Init(int &argc, char** &argv) { MPI_Init(&argc, &argv); }
+void comm_t::Init(int &argc, char** &argv, const bool threadMultiple) {
+  if (threadMultiple) {
+    int provided;
+    MPI_Init_thread(&argc, &argv, MPI_THREAD_MULTIPLE, &provided);
+  } else {
+    MPI_Init(&argc, &argv);
+  }
+}
 void comm_t::Finalize() { MPI_Finalize(); }
 
+bool comm_t::ThreadMultiple() {
+  int provided;
+  MPI_Query_thread(&provided);
+  return provided==MPI_THREAD_MULTIPLE;
+}
+
 /*Static handle to MPI_COMM_WORLD*/
 comm_t comm_t::world() {
   comm_t c;
@@ -79,6 +92,24 @@ comm_t comm_t::Split(const int color, const int key) const {
   return c;
 }
 
+/*Split into shared memory (i.e. node-local) communicators*/
+comm_t comm_t::SplitShared(const int key) const {
+  comm_t c;
+  /*Make a new comm shared_ptr, which will call MPI_Comm_free when destroyed*/
+  c.comm_ptr = std::shared_ptr<MPI_Comm>(new MPI_Comm,
+                                        [](MPI_Comm *comm) {
+                                          if (*comm != MPI_COMM_NULL)
+                                            MPI_Comm_free(comm);
+                                          delete comm;
+                                        });
+
+  MPI_Comm_split_type(comm(), MPI_COMM_TYPE_SHARED, key,
+                      MPI_INFO_NULL, c.comm_ptr.get());
+  MPI_Comm_rank(c.comm(), &(c._rank));
+  MPI_Comm_size(c.comm(), &(c._size));
+  return c;
+}
+
 /*Rank and size getters*/
 const int comm_t::rank() const {
   return _rank;
@@ -103,8 +134,83 @@ void comm_t::Waitall(const int count, memory<request_t> &requests) const {
   MPI_Waitall(count, requests.ptr(), MPI_STATUSES_IGNORE);
 }
 
+int comm_t::Waitany(const int count, memory<request_t> &requests) const {
+  int index;
+  MPI_Waitany(count, requests.ptr(), &index, MPI_STATUS_IGNORE);
+  return index;
+}
+
+bool comm_t::Testall(const int count, memory<request_t> &requests) const {
+  int flag;
+  MPI_Testall(count, requests.ptr(), &flag, MPI_STATUSES_IGNORE);
+  return flag;
+}
+
+void comm_t::TypeFree(datatype_t &type) const {
+  if (type != MPI_DATATYPE_NULL) MPI_Type_free(&type);
+}
+
+void comm_t::Poll() const {
+  int flag;
+  MPI_Iprobe(MPI_ANY_SOURCE, MPI_ANY_TAG, comm(), &flag, MPI_STATUS_IGNORE);
+}
+
 void comm_t::Barrier() const {
   MPI_Barrier(comm());
 }
 
+/*One-sided communication*/
+void comm_t::WinFree(win_t &win) const {
+  if (win != MPI_WIN_NULL) MPI_Win_free(&win);
+}
+
+comm_t::group_t comm_t::GroupIncl(const int count, const memory<int> ranks) const {
+  MPI_Group commGroup, group;
+  MPI_Comm_group(comm(), &commGroup);
+  MPI_Group_incl(commGroup, count, ranks.ptr(), &group);
+  MPI_Group_free(&commGroup);
+  return group;
+}
+
+void comm_t::GroupFree(group_t &group) const {
+  if (group != MPI_GROUP_NULL && group != MPI_GROUP_EMPTY)
+    MPI_Group_free(&group);
+}
+
+memory<int> comm_t::WorldRanks() const {
+  memory<int> ranks(size()), worldRanks(size());
+  for (int r=0;r<size();++r) ranks[r] = r;
+
+  MPI_Group commGroup, worldGroup;
+  MPI_Comm_group(comm(), &commGroup);
+  MPI_Comm_group(MPI_COMM_WORLD, &worldGroup);
+  MPI_Group_translate_ranks(commGroup, size(), ranks.ptr(),
+                            worldGroup, worldRanks.ptr());
+  MPI_Group_free(&commGroup);
+  MPI_Group_free(&worldGroup);
+  return worldRanks;
+}
+
+void comm_t::WinPost(group_t group, win_t win) const {
+  MPI_Win_post(group, 0, win);
+}
+void comm_t::WinStart(group_t group, win_t win) const {
+  MPI_Win_start(group, 0, win);
+}
+void comm_t::WinComplete(win_t win) const {
+  MPI_Win_complete(win);
+}
+void comm_t::WinWait(win_t win) const {
+  MPI_Win_wait(win);
+}
+void comm_t::WinLockAll(win_t win) const {
+  MPI_Win_lock_all(MPI_MODE_NOCHECK, win);
+}
+void comm_t::WinUnlockAll(win_t win) const {
+  MPI_Win_unlock_all(win);
+}
+void comm_t::WinSync(win_t win) const {
+  MPI_Win_sync(win);
+}
+
 } //namespace libp
@@ -25,13 +25,7 @@ SOFTWARE.
 */
 
 #include "mesh.hpp"
-
-#ifdef GLIBCXX_PARALLEL
-#include <parallel/algorithm>
-using __gnu_parallel::sort;
-#else
-using std::sort;
-#endif
+#include "radixSort.hpp"
 
 namespace libp {
 
@@ -46,7 +40,6 @@ typedef struct {
 
 }face_t;
 
-
 // mesh is the local partition
 void mesh_t::Connect(){
 
@@ -84,11 +77,7 @@ void mesh_t::Connect(){
   }
 
   /* sort faces by their vertex number pairs */
-  sort(faces.ptr(), faces.ptr()+Nelements*Nfaces,
-       [&](const face_t& a, const face_t& b) {
-         return std::lexicographical_compare(a.v, a.v+NfaceVertices,
-                                             b.v, b.v+NfaceVertices);
-       });
+  RadixSortByVertices(Nelements*Nfaces, faces, NfaceVertices);
 
   /* scan through sorted face lists looking for adjacent
      faces that have the same vertex ids */
@@ -106,13 +95,9 @@ void mesh_t::Connect(){
   }
 
   /* resort faces back to the original element/face ordering */
-  sort(faces.ptr(), faces.ptr()+Nelements*Nfaces,
-       [](const face_t& a, const face_t& b) {
-         if(a.element < b.element) return true;
-         if(a.element > b.element) return false;
-
-         return (a.face < b.face);
-       });
+  RadixSort(Nelements*Nfaces, faces,
+            [](const face_t& a) { return static_cast<uint64_t>(a.element); },
+            [](const face_t& a) { return static_cast<uint64_t>(a.face); });
 
   /* extract the element to element and element to face connectivity */
   #pragma omp parallel for collapse(2)
@@ -131,26 +116,34 @@ void mesh_t::Connect(){
    * Interprocess Connectivity
    *****************************/
 
+  // rendezvous faces in contiguous blocks of the global vertex id range, so
+  // faces mostly meet on a rank near the ones that share them
+  hlong maxVertex = 0;
+  for(dlong n=0;n<Nelements*Nverts;++n)
+    maxVertex = std::max(maxVertex, EToV[n]);
+  comm.Allreduce(maxVertex, comm_t::Max);
+  const hlong blockSize = maxVertex/size + 1;
+
   // count # of elements to send to each rank based on
-  // minimum {vertex id % size}
+  // maximum {vertex id / blockSize}
   memory<int> Nsend(size, 0);
   memory<int> Nrecv(size, 0);
   memory<int> sendOffsets(size, 0);
-  memory<int> recvOffsets(size, 0);
+  memory<int> recvOffsets(size+1, 0);
 
   // WARNING: In some corner cases, the number of faces to send may overrun int storage
   int allNsend = 0;
   for(dlong e=0;e<Nelements;++e){
     for(int f=0;f<Nfaces;++f){
       if(EToE[e*Nfaces+f]==-1){
-        // find rank of destination for sorting based on max(face vertices)%size
+        // find rank of destination for sorting based on max(face vertices)/blockSize
         hlong maxv = 0;
         for(int n=0;n<NfaceVertices;++n){
           int nid = faceVertices[f*NfaceVertices+n];
           hlong id = EToV[e*Nverts + nid];
           maxv = std::max(maxv, id);
         }
-        int destRank = (int) (maxv%size);
+        int destRank = (int) (maxv/blockSize);
 
         // increment send size for
         ++Nsend[destRank];
@@ -175,14 +168,14 @@ void mesh_t::Connect(){
     for(int f=0;f<Nfaces;++f){
       if(EToE[e*Nfaces+f]==-1){
 
-        // find rank of destination for sorting based on max(face vertices)%size
+        // find rank of destination for sorting based on max(face vertices)/blockSize
         hlong maxv = 0;
         for(int n=0;n<NfaceVertices;++n){
           int nid = faceVertices[f*NfaceVertices+n];
           hlong id = EToV[e*Nverts + nid];
           maxv = std::max(maxv, id);
         }
-        int destRank = (int) (maxv%size);
+        int destRank = (int) (maxv/blockSize);
 
         // populate face to send out staged in segment of sendFaces array
         int id = sendOffsets[destRank]+Nsend[destRank];
@@ -208,31 +201,17 @@ void mesh_t::Connect(){
     }
   }
 
-  // exchange counts
-  comm.Alltoall(Nsend, Nrecv);
+  // exchange parallel faces. Only the ranks we send faces to are contacted,
+  // and the incoming counts are discovered along the way
+  memory<face_t> recvFaces;
+  comm.SparseAlltoallv(sendFaces, Nsend, sendOffsets,
+                       recvFaces, Nrecv, recvOffsets);
 
   // count incoming faces
-  int allNrecv = 0;
-  for(int rr=0;rr<size;++rr)
-    allNrecv += Nrecv[rr];
-
-  // find offsets for recv data
-  for(int rr=1;rr<size;++rr)
-    recvOffsets[rr] = recvOffsets[rr-1] + Nrecv[rr-1]; // offsets
-
-  // buffer for incoming face data
-  memory<face_t> recvFaces(allNrecv);
-
-  // exchange parallel faces
-  comm.Alltoallv(sendFaces, Nsend, sendOffsets,
-                 recvFaces, Nrecv, recvOffsets);
+  int allNrecv = recvOffsets[size];
 
   // local sort allNrecv received faces
-  sort(recvFaces.ptr(), recvFaces.ptr()+allNrecv,
-      [&](const face_t& a, const face_t& b) {
-        return std::lexicographical_compare(a.v, a.v+NfaceVertices,
-                                            b.v, b.v+NfaceVertices);
-      });
+  RadixSortByVertices(allNrecv, recvFaces, NfaceVertices);
 
   // find matches
   #pragma omp parallel for
@@ -251,20 +230,14 @@ void mesh_t::Connect(){
   }
 
   // sort back to original ordering
-  sort(recvFaces.ptr(), recvFaces.ptr()+allNrecv,
-      [](const face_t& a, const face_t& b) {
-        if(a.rank < b.rank) return true;
-        if(a.rank > b.rank) return false;
-
-        if(a.element < b.element) return true;
-        if(a.element > b.element) return false;
-
-        return (a.face < b.face);
-      });
+  RadixSort(allNrecv, recvFaces,
+            [](const face_t& a) { return static_cast<uint64_t>(a.rank); },
+            [](const face_t& a) { return static_cast<uint64_t>(a.element); },
+            [](const face_t& a) { return static_cast<uint64_t>(a.face); });
 
   // send faces back from whence they came
-  comm.Alltoallv(recvFaces, Nrecv, recvOffsets,
-                 sendFaces, Nsend, sendOffsets);
+  comm.NeighborAlltoallv(recvFaces, Nrecv, recvOffsets,
+                         sendFaces, Nsend, sendOffsets);
 
   // extract connectivity info
   #pragma omp parallel for
@@ -23,61 +23,268 @@ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
 SOFTWARE.
 
 */
-
 #include "mesh.hpp"
+#include "radixSort.hpp"
 
 namespace libp {
 
-// uniquely label each node with a global index, used for gatherScatter
-void mesh_t::ConnectNodes(){
+// an edge or face of an element, keyed by its sorted global vertex ids
+typedef struct {
+  hlong v[4];  // vertices of the entity
+  hlong id;    // global entity number
+  dlong index; // position in the list it was made in
+}entity_t;
 
-  hlong localNnodes = Np*Nelements;
-  hlong gatherNodeStart = localNnodes;
-  comm.Scan(localNnodes, gatherNodeStart);
-  gatherNodeStart -= localNnodes;
+// Give every distinct entity in the lists of all ranks a global number in
+// [0, Nglobal), and return Nglobal. Each rank sends one copy of its entities
+// to the rank owning the block of the vertex id range holding their first
+// vertex, which numbers the entities it receives and sends the numbers back
+static hlong NumberEntities(comm_t comm, const dlong N,
+                            memory<entity_t> entities, const int W,
+                            const hlong blockSize) {
+  const int size = comm.size();
 
-  // form continuous node numbering (local=>virtual gather)
-  globalIds.malloc((totalHaloPairs+Nelements)*Np);
+  for(dlong n=0;n<N;++n) entities[n].index = n;
+  RadixSortByVertices(N, entities, W);
 
-  // use local numbering
-  #pragma omp parallel for collapse(2)
-  for(dlong e=0;e<Nelements;++e){
-    for(int n=0;n<Np;++n){
-      dlong id = e*Np+n;
-      globalIds[id] = 1 + id + gatherNodeStart;
+  // keep one copy of each entity. Sorting by the first vertex also groups
+  // the copies by their destination rank
+  memory<dlong> uniqueIds(N);
+  dlong Nunique = 0;
+  for(dlong n=0;n<N;++n){
+    if(n==0 || !std::equal(entities[n].v, entities[n].v+W, entities[n-1].v))
+      Nunique++;
+    uniqueIds[n] = Nunique-1;
+  }
+
+  memory<entity_t> sendEntities(Nunique);
+  memory<int> sendCounts(size, 0);
+  memory<int> recvCounts(size);
+  memory<int> sendOffsets(size+1);
+  memory<int> recvOffsets(size+1);
+
+  for(dlong n=0;n<N;++n){
+    if(n==0 || uniqueIds[n]!=uniqueIds[n-1]){
+      sendEntities[uniqueIds[n]] = entities[n];
+      sendCounts[entities[n].v[0]/blockSize]++;
     }
   }
 
-  hlong gatherChange = 1;
+  sendOffsets[0] = 0;
+  for(int r=0;r<size;++r)
+    sendOffsets[r+1] = sendOffsets[r] + sendCounts[r];
+
+  memory<entity_t> recvEntities;
+  comm.SparseAlltoallv(sendEntities, sendCounts, sendOffsets,
+                       recvEntities, recvCounts, recvOffsets);
+
+  const dlong Nrecv = recvOffsets[size];
+  for(dlong n=0;n<Nrecv;++n) recvEntities[n].index = n;
+  RadixSortByVertices(Nrecv, recvEntities, W);
+
+  // number the distinct entities in this rank's block
+  hlong Nlocal = 0;
+  for(dlong n=0;n<Nrecv;++n){
+    if(n==0 || !std::equal(recvEntities[n].v, recvEntities[n].v+W, recvEntities[n-1].v))
+      Nlocal++;
+    recvEntities[n].id = Nlocal-1;
+  }
+
+  hlong offset = Nlocal;
+  comm.Scan(Nlocal, offset);
+  offset -= Nlocal;
+
+  hlong Nglobal = Nlocal;
+  comm.Allreduce(Nglobal);
+
+  for(dlong n=0;n<Nrecv;++n) recvEntities[n].id += offset;
 
-  // keep comparing numbers on positive and negative traces until convergence
-  while(gatherChange>0){
+  // return the numbers in the order the entities were received
+  RadixSort(Nrecv, recvEntities,
+            [](const entity_t& a) { return static_cast<uint64_t>(a.index); });
 
-    // reset change counter
-    gatherChange = 0;
+  comm.NeighborAlltoallv(recvEntities, recvCounts, recvOffsets,
+                         sendEntities, sendCounts, sendOffsets);
 
-    // send halo data and recv into extension of buffer
-    halo.Exchange(globalIds, Np);
+  for(dlong n=0;n<N;++n) entities[n].id = sendEntities[uniqueIds[n]].id;
 
-    // compare trace nodes
-    #pragma omp parallel for collapse(2)
+  // back to the original ordering
+  RadixSort(N, entities,
+            [](const entity_t& a) { return static_cast<uint64_t>(a.index); });
+
+  return Nglobal;
+}
+
+// uniquely label each node with a global index, used for gatherScatter.
+//
+// Each node is labelled by the smallest entity of the mesh holding it (a
+// vertex, an edge, a face, or the element interior) and its position in
+// that entity, in an orientation fixed by the global vertex ids so every
+// element sharing the entity agrees on it. Vertices and element interiors
+// are numbered directly, and edges and faces at a single rendezvous, so the
+// cost does not depend on how far apart the elements sharing a node are.
+void mesh_t::ConnectNodes(){
+
+  const int Nm = N-1; // interior nodes on each edge
+
+  // local vertex at each corner of the reference element, indexed by
+  // whether the corner is at the end of the r, s, and t directions
+  const int cornerVertex[2][2][2] = {{{0,1},{3,2}},{{4,5},{7,6}}}; //[t][s][r]
+
+  auto corner = [&](const dlong e, const int bits[3]) {
+    return EToV[e*Nverts + cornerVertex[bits[2]][bits[1]][bits[0]]];
+  };
+
+  // the two directions other than d, in order
+  auto others = [](const int d, int& d0, int& d1) {
+    d0 = (d==0) ? 1 : 0;
+    d1 = (d==2) ? 1 : 2;
+  };
+
+  hlong maxVertex = 0;
+  for(dlong n=0;n<Nelements*Nverts;++n)
+    maxVertex = std::max(maxVertex, EToV[n]);
+  comm.Allreduce(maxVertex, comm_t::Max);
+  const hlong Nvertices = maxVertex+1;
+
+  // rendezvous in contiguous blocks of the global vertex id range
+  const hlong blockSize = maxVertex/size + 1;
+
+  const int NelementEdges = 12;
+  const int NelementFaces = 6;
+
+  // edge a*4+b runs along direction a, at the corners b of the others
+  memory<entity_t> edges(Nelements*NelementEdges);
+  // face c*2+b is at the end b of direction c
+  memory<entity_t> faces(Nelements*NelementFaces);
+
+  hlong NedgesGlobal = 0, NfacesGlobal = 0;
+  if (Nm>0) {
+    #pragma omp parallel for
     for(dlong e=0;e<Nelements;++e){
-      for(int n=0;n<Nfp*Nfaces;++n){
-        dlong id  = e*Nfp*Nfaces + n;
-        dlong idM = vmapM[id];
-        dlong idP = vmapP[id];
-        hlong gidM = globalIds[idM];
-        hlong gidP = globalIds[idP];
-
-        if(gidP<gidM){
-          ++gatherChange;
-          globalIds[idM] = gidP;
+      for(int a=0;a<3;++a){
+        int o0, o1;
+        others(a, o0, o1);
+        for(int b=0;b<4;++b){
+          int bits[3];
+          bits[o0] = b&1;
+          bits[o1] = b>>1;
+
+          bits[a] = 0;
+          const hlong g0 = corner(e, bits);
+          bits[a] = 1;
+          const hlong g1 = corner(e, bits);
+
+          entity_t& edge = edges[e*NelementEdges + a*4 + b];
+          edge.v[0] = std::min(g0, g1);
+          edge.v[1] = std::max(g0, g1);
+          edge.v[2] = 0;
+          edge.v[3] = 0;
+        }
+      }
+
+      for(int c=0;c<3;++c){
+        int d0, d1;
+        others(c, d0, d1);
+        for(int b=0;b<2;++b){
+          int bits[3];
+          bits[c] = b;
+
+          entity_t& face = faces[e*NelementFaces + c*2 + b];
+          for(int n=0;n<4;++n){
+            bits[d0] = n&1;
+            bits[d1] = n>>1;
+            face.v[n] = corner(e, bits);
+          }
+          std::sort(face.v, face.v+4, std::less<hlong>());
         }
       }
     }
 
-    // sum up changes
-    comm.Allreduce(gatherChange);
+    NedgesGlobal = NumberEntities(comm, Nelements*NelementEdges, edges, 2, blockSize);
+    NfacesGlobal = NumberEntities(comm, Nelements*NelementFaces, faces, 4, blockSize);
+  }
+
+  hlong localNelements = Nelements;
+  hlong elementStart = localNelements;
+  comm.Scan(localNelements, elementStart);
+  elementStart -= localNelements;
+
+  // label ranges of the vertices, edges, faces, and element interiors
+  const hlong edgeStart     = Nvertices;
+  const hlong faceStart     = edgeStart + NedgesGlobal*Nm;
+  const hlong interiorStart = faceStart + NfacesGlobal*Nm*Nm;
+
+  globalIds.malloc(Nelements*Np);
+
+  #pragma omp parallel for collapse(2)
+  for(dlong e=0;e<Nelements;++e){
+    for(int n=0;n<Np;++n){
+      const int idx[3] = {n%Nq, (n/Nq)%Nq, n/(Nq*Nq)};
+
+      // directions the node is inside the element in, and the
+      // end of the element it is at in the others
+      int bits[3] = {0, 0, 0};
+      int dims[3];
+      int Ninterior = 0;
+      for(int d=0;d<3;++d){
+        if(idx[d]==N) bits[d] = 1;
+        else if(idx[d]>0) dims[Ninterior++] = d;
+      }
+
+      hlong label = 0;
+      if(Ninterior==0){ //vertex
+        label = corner(e, bits);
+
+      } else if(Ninterior==1){ //edge, counted from its lower vertex
+        const int a = dims[0];
+        int o0, o1;
+        others(a, o0, o1);
+
+        bits[a] = 0;
+        const hlong g0 = corner(e, bits);
+        bits[a] = 1;
+        const hlong g1 = corner(e, bits);
+
+        const int i = (g0<g1) ? idx[a] : N-idx[a];
+        const hlong edge = edges[e*NelementEdges + a*4 + bits[o0] + 2*bits[o1]].id;
+        label = edgeStart + edge*Nm + (i-1);
+
+      } else if(Ninterior==2){ //face, from its lowest vertex towards its lower neighbor first
+        const int ds = dims[0];
+        const int dt = dims[1];
+        const int c = 3-ds-dt;
+
+        hlong g[2][2];
+        for(int ss=0;ss<2;++ss){
+          for(int tt=0;tt<2;++tt){
+            bits[ds] = ss;
+            bits[dt] = tt;
+            g[ss][tt] = corner(e, bits);
+          }
+        }
+
+        int so=0, to=0;
+        for(int ss=0;ss<2;++ss)
+          for(int tt=0;tt<2;++tt)
+            if(g[ss][tt]<g[so][to]) { so=ss; to=tt; }
+
+        const int is = so ? N-idx[ds] : idx[ds];
+        const int it = to ? N-idx[dt] : idx[dt];
+        const bool sFirst = g[1-so][to] < g[so][1-to];
+        const int i = sFirst ? is : it;
+        const int j = sFirst ? it : is;
+
+        const hlong face = faces[e*NelementFaces + c*2 + bits[c]].id;
+        label = faceStart + face*Nm*Nm + (i-1) + (j-1)*Nm;
+
+      } else { //element interior
+        label = interiorStart + (elementStart+e)*Nm*Nm*Nm
+              + (idx[0]-1) + (idx[1]-1)*Nm + (idx[2]-1)*Nm*Nm;
+      }
+
+      globalIds[e*Np+n] = 1 + label;
+    }
   }
 }
 
@@ -25,63 +25,109 @@ SOFTWARE.
 */
 
 #include "mesh.hpp"
+#include "radixSort.hpp"
 
 namespace libp {
 
-void mesh_t::GatherScatterSetup() {
-
-  dlong Ntotal = Nverts*(Nelements+totalHaloPairs);
+// a vertex sent to its rendezvous rank, with the range of ranks holding it
+typedef struct {
+  hlong v;     // global vertex id
+  dlong index; // position in the sender's list
+  int minRank; // smallest rank holding the vertex
+  int maxRank; // largest rank holding the vertex
+}vertexRanks_t;
 
-  memory<int> minRank(Ntotal);
-  memory<int> maxRank(Ntotal);
+void mesh_t::GatherScatterSetup() {
 
-  for (dlong i=0;i<Ntotal;i++) {
-    minRank[i] = rank;
-    maxRank[i] = rank;
+  // find the range of ranks holding each vertex in a single rendezvous: each
+  // rank sends its distinct vertices to the rank owning the block of the
+  // global vertex id range holding them, which reduces the ranks of each
+  // vertex and sends the result back
+  dlong Ntotal = Nverts*Nelements;
+
+  hlong maxVertex = 0;
+  for(dlong n=0;n<Ntotal;++n)
+    maxVertex = std::max(maxVertex, EToV[n]);
+  comm.Allreduce(maxVertex, comm_t::Max);
+
+  const hlong blockSize = maxVertex/size + 1;
+
+  memory<hlong> vertices(Ntotal);
+  vertices.copyFrom(EToV, Ntotal);
+  RadixSort(Ntotal, vertices,
+            [](const hlong& v) { return static_cast<uint64_t>(v); });
+
+  // distinct vertices, grouped by their destination rank
+  dlong Nunique = 0;
+  for(dlong n=0;n<Ntotal;++n)
+    if(n==0 || vertices[n]!=vertices[n-1]) vertices[Nunique++] = vertices[n];
+
+  memory<vertexRanks_t> sendVertices(Nunique);
+  memory<int> sendCounts(size, 0);
+  memory<int> recvCounts(size);
+  memory<int> sendOffsets(size+1);
+  memory<int> recvOffsets(size+1);
+
+  for(dlong n=0;n<Nunique;++n){
+    sendVertices[n].v = vertices[n];
+    sendVertices[n].minRank = rank;
+    sendVertices[n].maxRank = rank;
+    sendCounts[vertices[n]/blockSize]++;
   }
 
-  hlong gatherChange = 1;
-
-  // keep comparing numbers on positive and negative traces until convergence
-  while(gatherChange>0){
-
-    // reset change counter
-    gatherChange = 0;
-
-    // send halo data and recv into extension of buffer
-    halo.Exchange(minRank, Nverts);
-    halo.Exchange(maxRank, Nverts);
-
-    // compare trace vertices
-    #pragma omp parallel for collapse(2)
-    for(dlong e=0;e<Nelements;++e){
-      for(int n=0;n<Nfaces*NfaceVertices;++n){
-        dlong id  = e*Nfaces*NfaceVertices + n;
-        dlong idM = VmapM[id];
-        dlong idP = VmapP[id];
-
-        int minRankM = minRank[idM];
-        int minRankP = minRank[idP];
+  sendOffsets[0] = 0;
+  for(int rr=0;rr<size;++rr)
+    sendOffsets[rr+1] = sendOffsets[rr] + sendCounts[rr];
+
+  memory<vertexRanks_t> recvVertices;
+  comm.SparseAlltoallv(sendVertices, sendCounts, sendOffsets,
+                       recvVertices, recvCounts, recvOffsets);
+
+  const dlong Nrecv = recvOffsets[size];
+  for(dlong n=0;n<Nrecv;++n) recvVertices[n].index = n;
+
+  RadixSort(Nrecv, recvVertices,
+            [](const vertexRanks_t& a) { return static_cast<uint64_t>(a.v); });
+
+  // reduce the rank range over each group of copies of a vertex
+  for(dlong n=0;n<Nrecv;){
+    dlong m = n;
+    int minR = recvVertices[n].minRank;
+    int maxR = recvVertices[n].maxRank;
+    while(m<Nrecv && recvVertices[m].v==recvVertices[n].v){
+      minR = std::min(minR, recvVertices[m].minRank);
+      maxR = std::max(maxR, recvVertices[m].maxRank);
+      m++;
+    }
+    for(dlong i=n;i<m;++i){
+      recvVertices[i].minRank = minR;
+      recvVertices[i].maxRank = maxR;
+    }
+    n = m;
+  }
 
-        int maxRankM = maxRank[idM];
-        int maxRankP = maxRank[idP];
+  // return the ranges in the order the vertices were received
+  RadixSort(Nrecv, recvVertices,
+            [](const vertexRanks_t& a) { return static_cast<uint64_t>(a.index); });
 
-        if(minRankP<minRankM){
-          gatherChange=1;
-          minRank[idM] = minRankP;
-        }
+  comm.NeighborAlltoallv(recvVertices, recvCounts, recvOffsets,
+                         sendVertices, sendCounts, sendOffsets);
 
-        if(maxRankP>maxRankM){
-          gatherChange=1;
-          maxRank[idM] = maxRankP;
-        }
-      }
-    }
+  memory<int> minRank(Ntotal);
+  memory<int> maxRank(Ntotal);
 
-    // sum up changes
-    comm.Allreduce(gatherChange);
+  #pragma omp parallel for
+  for(dlong n=0;n<Ntotal;++n){
+    const dlong id = std::lower_bound(vertices.ptr(), vertices.ptr()+Nunique, EToV[n])
+                     - vertices.ptr();
+    minRank[n] = sendVertices[id].minRank;
+    maxRank[n] = sendVertices[id].maxRank;
   }
 
+  vertices.free();
+  sendVertices.free();
+  recvVertices.free();
+
   // count elements that contribute to global C0 gather-scatter
   dlong globalCount = 0;
   dlong localCount = 0;
@@ -126,10 +172,10 @@ void mesh_t::GatherScatterSetup() {
   minRank.free(); maxRank.free();
 
 
-  //make a masked version of the global id numbering
-  maskedGlobalIds.malloc(Nelements*Np);
-  for (dlong n=0;n<Nelements*Np;++n)
-    maskedGlobalIds[n] = globalIds[n];
+  //mask the global id numbering in place, the unmasked ids are not needed
+  // again
+  maskedGlobalIds = globalIds.slice(0, Nelements*Np);
+  globalIds.free();
 
   //The mesh is just a structured brick, so we don't have to worry about
   // singleton corners or edges that are on the boundary. Just
@@ -152,9 +198,15 @@ void mesh_t::GatherScatterSetup() {
   //use the masked ids to make another gs handle (signed so the gather is defined)
   bool verbose = platform.settings().compareSetting("VERBOSE", "TRUE");
   bool unique = true; //flag a unique node in every gather node
+
+  //tune for the transposed gather of Ax and the halo exchange of gHalo
+  std::vector<ogs::exchangeConfig_t> configs = {{1, ogs::Trans}, {1, ogs::NoTrans}};
   ogsMasked.Setup(Nelements*Np, maskedGlobalIds,
                   comm, ogs::Signed, ogs::Auto,
-                  unique, verbose, platform);
+                  unique, verbose, platform, configs);
+
+  //the gs handle holds everything it needs from the masked ids
+  maskedGlobalIds.free();
 
   gHalo.SetupFromGather(ogsMasked);
 
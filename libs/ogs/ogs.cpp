@@ -50,6 +50,8 @@ void ogs_t::GatherScatterStart(deviceMemory<T> o_v,
                                const int k,
                                const Op op,
                                const Transpose trans){
+  exchangeTimer_t timer = SelectExchange(k, trans);
+
   exchange->AllocBuffer(k*sizeof(T));
 
   deviceMemory<T> o_haloBuf = exchange->o_workspace;
@@ -60,6 +62,9 @@ void ogs_t::GatherScatterStart(deviceMemory<T> o_v,
   if (exchange->gpu_aware) {
     //prepare MPI exchange
     exchange->Start(o_haloBuf, k, op, trans);
+  } else if (exchange->staged) {
+    //stage the exchange through the host peer by peer
+    exchange->StagedStart(o_haloBuf, k, op, trans);
   } else {
     //get current stream
     device_t &device = platform.device;
@@ -70,13 +75,14 @@ void ogs_t::GatherScatterStart(deviceMemory<T> o_v,
     //if not using gpu-aware mpi move the halo buffer to the host
     const dlong Nhalo = (trans == NoTrans) ? NhaloP : NhaloT;
 
-    //wait for o_haloBuf to be ready
-    device.finish();
+    //wait for the work producing o_haloBuf
+    device.waitFor(device.tagStream());
 
-    //queue copy to host
+    //queue copy to host, and tag its completion
     device.setStream(dataStream);
     haloBuf.copyFrom(o_haloBuf, Nhalo*k,
                      0, "async: true");
+    dataTag = device.tagStream();
     device.setStream(currentStream);
   }
 }
@@ -86,6 +92,7 @@ void ogs_t::GatherScatterFinish(deviceMemory<T> o_v,
                                 const int k,
                                 const Op op,
                                 const Transpose trans){
+  exchangeTimer_t timer = SelectExchange(k, trans, /*finish=*/true);
 
   //queue local gs operation
   gatherLocal->GatherScatter(o_v, k, op, trans);
@@ -95,33 +102,40 @@ void ogs_t::GatherScatterFinish(deviceMemory<T> o_v,
   if (exchange->gpu_aware) {
     //finish MPI exchange
     exchange->Finish(o_haloBuf, k, op, trans);
+  } else if (exchange->staged) {
+    //copy received chunks back as they arrive
+    exchange->StagedFinish(o_haloBuf, k, op, trans);
   } else {
     pinnedMemory<T> haloBuf = exchange->h_workspace;
 
-    //get current stream
     device_t &device = platform.device;
-    stream_t currentStream = device.getStream();
 
-    //synchronize data stream to ensure the buffer is on the host
-    device.setStream(dataStream);
-    device.finish();
+    //wait for the copy of the halo buffer to the host
+    device.waitFor(dataTag);
 
     /*MPI exchange of host buffer*/
     exchange->Start (haloBuf, k, op, trans);
     exchange->Finish(haloBuf, k, op, trans);
 
-    // copy recv back to device
+    // copy recv back to device, ordered before later work on the current stream
     const dlong Nhalo = (trans == Trans) ? NhaloP : NhaloT;
     haloBuf.copyTo(o_haloBuf, Nhalo*k,
                    0, "async: true");
-    device.finish(); //wait for transfer to finish
-    device.setStream(currentStream);
   }
 
   //write exchanged halo buffer back to vector
   gatherHalo->Scatter(o_v, o_haloBuf, k, trans);
 }
 
+template<typename T>
+ogsFuture_t ogs_t::GatherScatterAsync(deviceMemory<T> o_v,
+                                      const int k,
+                                      const Op op,
+                                      const Transpose trans){
+  return Launch([=]() { GatherScatterStart (o_v, k, op, trans); },
+                [=]() { GatherScatterFinish(o_v, k, op, trans); });
+}
+
 template
 void ogs_t::GatherScatter(deviceMemory<float> v, const int k,
                           const Op op, const Transpose trans);
@@ -135,6 +149,19 @@ template
 void ogs_t::GatherScatter(deviceMemory<long long int> v, const int k,
                           const Op op, const Transpose trans);
 
+template
+ogsFuture_t ogs_t::GatherScatterAsync(deviceMemory<float> v, const int k,
+                                      const Op op, const Transpose trans);
+template
+ogsFuture_t ogs_t::GatherScatterAsync(deviceMemory<double> v, const int k,
+                                      const Op op, const Transpose trans);
+template
+ogsFuture_t ogs_t::GatherScatterAsync(deviceMemory<int> v, const int k,
+                                      const Op op, const Transpose trans);
+template
+ogsFuture_t ogs_t::GatherScatterAsync(deviceMemory<long long int> v, const int k,
+                                      const Op op, const Transpose trans);
+
 /********************************
  * Host GatherScatter
  ********************************/
@@ -152,6 +179,8 @@ void ogs_t::GatherScatterStart(memory<T> v,
                                const int k,
                                const Op op,
                                const Transpose trans){
+  exchangeTimer_t timer = SelectExchange(k, trans);
+
   exchange->AllocBuffer(k*sizeof(T));
 
   /*Cast workspace to type T*/
@@ -169,6 +198,7 @@ void ogs_t::GatherScatterFinish(memory<T> v,
                                 const int k,
                                 const Op op,
                                 const Transpose trans){
+  exchangeTimer_t timer = SelectExchange(k, trans, /*finish=*/true);
 
   /*Cast workspace to type T*/
   pinnedMemory<T> haloBuf = exchange->h_workspace;
@@ -216,6 +246,7 @@ void ogs_t::GatherStart(deviceMemory<T> o_gv,
                         const Op op,
                         const Transpose trans){
   AssertGatherDefined();
+  exchangeTimer_t timer = SelectExchange(k, Trans);
 
   deviceMemory<T> o_haloBuf = exchange->o_workspace;
 
@@ -228,6 +259,9 @@ void ogs_t::GatherStart(deviceMemory<T> o_gv,
     if (exchange->gpu_aware) {
       //prepare MPI exchange
       exchange->Start(o_haloBuf, k, op, Trans);
+    } else if (exchange->staged) {
+      //stage the exchange through the host peer by peer
+      exchange->StagedStart(o_haloBuf, k, op, Trans);
     } else {
       //get current stream
       device_t &device = platform.device;
@@ -236,13 +270,14 @@ void ogs_t::GatherStart(deviceMemory<T> o_gv,
       //if not using gpu-aware mpi move the halo buffer to the host
       pinnedMemory<T> haloBuf = exchange->h_workspace;
 
-      //wait for o_haloBuf to be ready
-      device.finish();
+      //wait for the work producing o_haloBuf
+      device.waitFor(device.tagStream());
 
-      //queue copy to host
+      //queue copy to host, and tag its completion
       device.setStream(dataStream);
       haloBuf.copyFrom(o_haloBuf, NhaloT*k,
                        0, "async: true");
+      dataTag = device.tagStream();
       device.setStream(currentStream);
     }
   } else {
@@ -258,6 +293,7 @@ void ogs_t::GatherFinish(deviceMemory<T> o_gv,
                          const Op op,
                          const Transpose trans){
   AssertGatherDefined();
+  exchangeTimer_t timer = SelectExchange(k, Trans, /*finish=*/true);
 
   deviceMemory<T> o_haloBuf = exchange->o_workspace;
 
@@ -269,34 +305,46 @@ void ogs_t::GatherFinish(deviceMemory<T> o_gv,
       //finish MPI exchange
       exchange->Finish(o_haloBuf, k, op, Trans);
 
+      //put the result at the end of o_gv
+      o_haloBuf.copyTo(o_gv + k*NlocalT,
+                       k*NhaloP, 0, "async: true");
+    } else if (exchange->staged) {
+      //copy received chunks back as they arrive
+      exchange->StagedFinish(o_haloBuf, k, op, Trans);
+
       //put the result at the end of o_gv
       o_haloBuf.copyTo(o_gv + k*NlocalT,
                        k*NhaloP, 0, "async: true");
     } else {
       pinnedMemory<T> haloBuf = exchange->h_workspace;
 
-      //get current stream
       device_t &device = platform.device;
-      stream_t currentStream = device.getStream();
 
-      //synchronize data stream to ensure the buffer is on the host
-      device.setStream(dataStream);
-      device.finish();
+      //wait for the copy of the halo buffer to the host
+      device.waitFor(dataTag);
 
       /*MPI exchange of host buffer*/
       exchange->Start (haloBuf, k, op, trans);
       exchange->Finish(haloBuf, k, op, trans);
 
-      // copy recv back to device
+      // copy recv back to device, ordered before later work on the current stream
       //put the result at the end of o_gv
       haloBuf.copyTo(o_gv + k*NlocalT, k*NhaloP,
                      0, "async: true");
-      device.finish(); //wait for transfer to finish
-      device.setStream(currentStream);
     }
   }
 }
 
+template<typename T>
+ogsFuture_t ogs_t::GatherAsync(deviceMemory<T> o_gv,
+                               deviceMemory<T> o_v,
+                               const int k,
+                               const Op op,
+                               const Transpose trans){
+  return Launch([=]() { GatherStart (o_gv, o_v, k, op, trans); },
+                [=]() { GatherFinish(o_gv, o_v, k, op, trans); });
+}
+
 template
 void ogs_t::Gather(deviceMemory<float> v, const deviceMemory<float> gv,
                    const int k, const Op op, const Transpose trans);
@@ -310,6 +358,19 @@ template
 void ogs_t::Gather(deviceMemory<long long int> v, const deviceMemory<long long int> gv,
                    const int k, const Op op, const Transpose trans);
 
+template
+ogsFuture_t ogs_t::GatherAsync(deviceMemory<float> v, deviceMemory<float> gv,
+                               const int k, const Op op, const Transpose trans);
+template
+ogsFuture_t ogs_t::GatherAsync(deviceMemory<double> v, deviceMemory<double> gv,
+                               const int k, const Op op, const Transpose trans);
+template
+ogsFuture_t ogs_t::GatherAsync(deviceMemory<int> v, deviceMemory<int> gv,
+                               const int k, const Op op, const Transpose trans);
+template
+ogsFuture_t ogs_t::GatherAsync(deviceMemory<long long int> v, deviceMemory<long long int> gv,
+                               const int k, const Op op, const Transpose trans);
+
 /********************************
  * Host Gather
  ********************************/
@@ -332,6 +393,7 @@ void ogs_t::GatherStart(memory<T> gv,
                         const Op op,
                         const Transpose trans){
   AssertGatherDefined();
+  exchangeTimer_t timer = SelectExchange(k, Trans);
 
   if (trans==Trans) { //if trans!=ogs::Trans theres no comms required
     exchange->AllocBuffer(k*sizeof(T));
@@ -357,6 +419,7 @@ void ogs_t::GatherFinish(memory<T> gv,
                          const Op op,
                          const Transpose trans){
   AssertGatherDefined();
+  exchangeTimer_t timer = SelectExchange(k, Trans, /*finish=*/true);
 
   //queue local g operation
   gatherLocal->Gather(gv, v, k, op, trans);
@@ -404,6 +467,7 @@ void ogs_t::ScatterStart(deviceMemory<T> o_v,
                          const int k,
                          const Transpose trans){
   AssertGatherDefined();
+  exchangeTimer_t timer = SelectExchange(k, NoTrans);
 
   deviceMemory<T> o_haloBuf = exchange->o_workspace;
 
@@ -417,11 +481,18 @@ void ogs_t::ScatterStart(deviceMemory<T> o_v,
       o_haloBuf.copyFrom(o_gv + k*NlocalT,
                          k*NhaloP, 0, "async: true");
 
-      //wait for o_haloBuf to be ready
+      //wait for the work producing o_haloBuf
       device.finish();
 
       //prepare MPI exchange
       exchange->Start(o_haloBuf, k, Add, NoTrans);
+    } else if (exchange->staged) {
+      //collect halo buffer
+      o_haloBuf.copyFrom(o_gv + k*NlocalT,
+                         k*NhaloP, 0, "async: true");
+
+      //stage the exchange through the host peer by peer
+      exchange->StagedStart(o_haloBuf, k, Add, NoTrans);
     } else {
       //get current stream
       stream_t currentStream = device.getStream();
@@ -430,12 +501,13 @@ void ogs_t::ScatterStart(deviceMemory<T> o_v,
       pinnedMemory<T> haloBuf = exchange->h_workspace;
 
       //wait for o_gv to be ready
-      device.finish();
+      device.waitFor(device.tagStream());
 
-      //queue copy to host
+      //queue copy to host, and tag its completion
       device.setStream(dataStream);
       haloBuf.copyFrom(o_gv + k*NlocalT, NhaloP*k,
                        0, "async: true");
+      dataTag = device.tagStream();
       device.setStream(currentStream);
     }
   }
@@ -447,6 +519,7 @@ void ogs_t::ScatterFinish(deviceMemory<T> o_v,
                           const int k,
                           const Transpose trans){
   AssertGatherDefined();
+  exchangeTimer_t timer = SelectExchange(k, NoTrans, /*finish=*/true);
 
   deviceMemory<T> o_haloBuf = exchange->o_workspace;
 
@@ -457,26 +530,24 @@ void ogs_t::ScatterFinish(deviceMemory<T> o_v,
     if (exchange->gpu_aware) {
       //finish MPI exchange
       exchange->Finish(o_haloBuf, k, Add, NoTrans);
+    } else if (exchange->staged) {
+      //copy received chunks back as they arrive
+      exchange->StagedFinish(o_haloBuf, k, Add, NoTrans);
     } else {
       pinnedMemory<T> haloBuf = exchange->h_workspace;
 
-      //get current stream
       device_t &device = platform.device;
-      stream_t currentStream = device.getStream();
 
-      //synchronize data stream to ensure the buffer is on the host
-      device.setStream(dataStream);
-      device.finish();
+      //wait for the copy of the halo buffer to the host
+      device.waitFor(dataTag);
 
       /*MPI exchange of host buffer*/
       exchange->Start (haloBuf, k, Add, NoTrans);
       exchange->Finish(haloBuf, k, Add, NoTrans);
 
-      // copy recv back to device
+      // copy recv back to device, ordered before later work on the current stream
       haloBuf.copyTo(o_haloBuf, NhaloT*k,
                      0, "async: true");
-      device.finish(); //wait for transfer to finish
-      device.setStream(currentStream);
     }
 
     //scatter halo buffer
@@ -487,6 +558,15 @@ void ogs_t::ScatterFinish(deviceMemory<T> o_v,
   }
 }
 
+template<typename T>
+ogsFuture_t ogs_t::ScatterAsync(deviceMemory<T> o_v,
+                                deviceMemory<T> o_gv,
+                                const int k,
+                                const Transpose trans){
+  return Launch([=]() { ScatterStart (o_v, o_gv, k, trans); },
+                [=]() { ScatterFinish(o_v, o_gv, k, trans); });
+}
+
 template
 void ogs_t::Scatter(deviceMemory<float> v, const deviceMemory<float> gv,
                     const int k, const Transpose trans);
@@ -500,6 +580,19 @@ template
 void ogs_t::Scatter(deviceMemory<long long int> v, const deviceMemory<long long int> gv,
                     const int k, const Transpose trans);
 
+template
+ogsFuture_t ogs_t::ScatterAsync(deviceMemory<float> v, deviceMemory<float> gv,
+                                const int k, const Transpose trans);
+template
+ogsFuture_t ogs_t::ScatterAsync(deviceMemory<double> v, deviceMemory<double> gv,
+                                const int k, const Transpose trans);
+template
+ogsFuture_t ogs_t::ScatterAsync(deviceMemory<int> v, deviceMemory<int> gv,
+                                const int k, const Transpose trans);
+template
+ogsFuture_t ogs_t::ScatterAsync(deviceMemory<long long int> v, deviceMemory<long long int> gv,
+                                const int k, const Transpose trans);
+
 /********************************
  * Host Scatter
  ********************************/
@@ -520,6 +613,7 @@ void ogs_t::ScatterStart(memory<T> v,
                          const int k,
                          const Transpose trans){
   AssertGatherDefined();
+  exchangeTimer_t timer = SelectExchange(k, NoTrans);
 
   if (trans==NoTrans) { //if trans!=ogs::NoTrans theres no comms required
     exchange->AllocBuffer(k*sizeof(T));
@@ -541,6 +635,7 @@ void ogs_t::ScatterFinish(memory<T> v,
                           const int k,
                           const Transpose trans){
   AssertGatherDefined();
+  exchangeTimer_t timer = SelectExchange(k, NoTrans, /*finish=*/true);
 
   //queue local s operation
   gatherLocal->Scatter(v, gv, k, trans);
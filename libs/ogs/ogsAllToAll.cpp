@@ -27,13 +27,7 @@ SOFTWARE.
 #include "ogs.hpp"
 #include "ogs/ogsUtils.hpp"
 #include "ogs/ogsExchange.hpp"
-
-#ifdef GLIBCXX_PARALLEL
-#include <parallel/algorithm>
-using __gnu_parallel::sort;
-#else
-using std::sort;
-#endif
+#include "radixSort.hpp"
 
 namespace libp {
 
@@ -70,6 +64,9 @@ inline void ogsAllToAll_t::Start(pinnedMemory<T> &buf, const int k,
     }
   }
 
+  for (int r=0;r<size;++r)
+    if (sendCounts[r]) RecordSend(r, sendCounts[r]*sizeof(T));
+
   // collect everything needed with single MPI all to all
   comm.Ialltoallv(sendBuf,     sendCounts, sendOffsets,
                   buf+Nhalo*k, recvCounts, recvOffsets,
@@ -80,7 +77,9 @@ template<typename T>
 inline void ogsAllToAll_t::Finish(pinnedMemory<T> &buf, const int k,
                            const Op op, const Transpose trans){
 
+  timePoint_t wait = Time();
   comm.Wait(request);
+  RecordWait(wait);
 
   //if we recvieved anything via MPI, gather the recv buffer and scatter
   // it back to to original vector
@@ -150,9 +149,14 @@ void ogsAllToAll_t::Finish(deviceMemory<T> &o_buf,
     }
   }
 
+  for (int r=0;r<size;++r)
+    if (sendCounts[r]) RecordSend(r, sendCounts[r]*sizeof(T));
+
   // collect everything needed with single MPI all to all
+  timePoint_t wait = Time();
   comm.Alltoallv(o_sendBuf,     sendCounts, sendOffsets,
                  o_buf+Nhalo*k, recvCounts, recvOffsets);
+  RecordWait(wait);
 
   //if we recvieved anything via MPI, gather the recv buffer and scatter
   // it back to to original vector
@@ -184,13 +188,9 @@ ogsAllToAll_t::ogsAllToAll_t(dlong Nshared,
   NhaloP = gatherHalo.NrowsN;
 
   // sort the list by rank to the order where they will be sent by MPI_Allgatherv
-  sort(sharedNodes.ptr(), sharedNodes.ptr()+Nshared,
-       [](const parallelNode_t& a, const parallelNode_t& b) {
-         if(a.rank < b.rank) return true; //group by rank
-         if(a.rank > b.rank) return false;
-
-         return a.newId < b.newId; //then order by the localId relative to this rank
-       });
+  RadixSort(Nshared, sharedNodes,
+            [](const parallelNode_t& a) { return static_cast<uint64_t>(a.rank); }, //group by rank
+            [](const parallelNode_t& a) { return static_cast<uint64_t>(a.newId); }); //then order by the localId relative to this rank
 
   //make mpi allgatherv counts and offsets
   mpiSendCountsT.calloc(size);
@@ -208,20 +208,29 @@ ogsAllToAll_t::ogsAllToAll_t(dlong Nshared,
     mpiSendCountsT[r]++;
   }
 
-  //shared counts
-  comm.Alltoall(mpiSendCountsT, mpiRecvCountsT);
-  comm.Alltoall(mpiSendCountsN, mpiRecvCountsN);
+  mpiSendOffsetsT[0] = 0;
+  for (int r=0;r<size;r++)
+    mpiSendOffsetsT[r+1] = mpiSendOffsetsT[r]+mpiSendCountsT[r];
+
+  //Send list of nodes to each rank. Only the ranks we share nodes with are
+  // contacted, and the positive node counts can be read off the nodes we recv
+  memory<parallelNode_t> recvNodes;
+  comm.SparseAlltoallv(sharedNodes, mpiSendCountsT, mpiSendOffsetsT,
+                         recvNodes, mpiRecvCountsT, mpiRecvOffsetsT);
+  dlong Nrecv = mpiRecvOffsetsT[size];
+
+  for (int r=0;r<size;r++) {
+    mpiRecvCountsN[r] = 0;
+    for (int n=mpiRecvOffsetsT[r];n<mpiRecvOffsetsT[r+1];n++)
+      if (recvNodes[n].sign>0) mpiRecvCountsN[r]++;
+  }
 
   //cumulative sum
   mpiSendOffsetsN[0] = 0;
-  mpiSendOffsetsT[0] = 0;
   mpiRecvOffsetsN[0] = 0;
-  mpiRecvOffsetsT[0] = 0;
   for (int r=0;r<size;r++) {
     mpiSendOffsetsN[r+1] = mpiSendOffsetsN[r]+mpiSendCountsN[r];
-    mpiSendOffsetsT[r+1] = mpiSendOffsetsT[r]+mpiSendCountsT[r];
     mpiRecvOffsetsN[r+1] = mpiRecvOffsetsN[r]+mpiRecvCountsN[r];
-    mpiRecvOffsetsT[r+1] = mpiRecvOffsetsT[r]+mpiRecvCountsT[r];
   }
 
   //make ops for scattering halo nodes before sending
@@ -244,14 +253,6 @@ ogsAllToAll_t::ogsAllToAll_t(dlong Nshared,
   o_sendIdsT = platform.malloc(sendIdsT);
   o_sendIdsN = platform.malloc(sendIdsN);
 
-  //send the node lists so we know what we'll receive
-  dlong Nrecv = mpiRecvOffsetsT[size];
-  memory<parallelNode_t> recvNodes(Nrecv);
-
-  //Send list of nodes to each rank
-  comm.Alltoallv(sharedNodes, mpiSendCountsT, mpiSendOffsetsT,
-                   recvNodes, mpiRecvCountsT, mpiRecvOffsetsT);
-
   //make ops for gathering halo nodes after an MPI_Allgatherv
   postmpi.platform = platform;
   postmpi.kind = Signed;
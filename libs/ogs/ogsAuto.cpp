@@ -29,14 +29,21 @@ SOFTWARE.
 #include "ogs/ogsOperator.hpp"
 #include "ogs/ogsExchange.hpp"
 #include "timer.hpp"
+#include <fstream>
+#include <limits>
+#include <algorithm>
+#include <cmath>
 
 namespace libp {
 
 namespace ogs {
 
-static void DeviceExchangeTest(ogsExchange_t* exchange, double time[3]) {
-  const int Ncold = 10;
-  const int Nhot  = 10;
+static void DeviceExchangeTest(ogsExchange_t* exchange,
+                               const int k,
+                               const Transpose trans,
+                               double time[3],
+                               const int Ncold = 10,
+                               const int Nhot  = 10) {
   double localTime, sumTime, minTime, maxTime;
 
   comm_t& comm = exchange->comm;
@@ -51,20 +58,25 @@ static void DeviceExchangeTest(ogsExchange_t* exchange, double time[3]) {
   for (int n=0;n<Ncold;++n) {
     if (exchange->gpu_aware) {
       /*GPU-aware exchange*/
-      exchange->Start (o_buf, 1, Add, Sym);
-      exchange->Finish(o_buf, 1, Add, Sym);
+      exchange->Start (o_buf, k, Add, trans);
+      exchange->Finish(o_buf, k, Add, trans);
+    } else if (exchange->staged) {
+      /*pipelined host staging*/
+      exchange->StagedStart (o_buf, k, Add, trans);
+      exchange->StagedFinish(o_buf, k, Add, trans);
+      device.finish();
     } else {
       //if not using gpu-aware mpi move the halo buffer to the host
-      o_buf.copyTo(buf, exchange->Nhalo,
+      o_buf.copyTo(buf, exchange->Nhalo*k,
                    0, "async: true");
       device.finish();
 
       /*MPI exchange of host buffer*/
-      exchange->Start (buf, 1, Add, Sym);
-      exchange->Finish(buf, 1, Add, Sym);
+      exchange->Start (buf, k, Add, trans);
+      exchange->Finish(buf, k, Add, trans);
 
       // copy recv back to device
-      o_buf.copyFrom(buf, exchange->Nhalo,
+      o_buf.copyFrom(buf, exchange->Nhalo*k,
                      0, "async: true");
       device.finish(); //wait for transfer to finish
     }
@@ -75,20 +87,25 @@ static void DeviceExchangeTest(ogsExchange_t* exchange, double time[3]) {
   for (int n=0;n<Nhot;++n) {
     if (exchange->gpu_aware) {
       /*GPU-aware exchange*/
-      exchange->Start (o_buf, 1, Add, Sym);
-      exchange->Finish(o_buf, 1, Add, Sym);
+      exchange->Start (o_buf, k, Add, trans);
+      exchange->Finish(o_buf, k, Add, trans);
+    } else if (exchange->staged) {
+      /*pipelined host staging*/
+      exchange->StagedStart (o_buf, k, Add, trans);
+      exchange->StagedFinish(o_buf, k, Add, trans);
+      device.finish();
     } else {
       //if not using gpu-aware mpi move the halo buffer to the host
-      o_buf.copyTo(buf, exchange->Nhalo,
+      o_buf.copyTo(buf, exchange->Nhalo*k,
                    0, "async: true");
       device.finish();
 
       /*MPI exchange of host buffer*/
-      exchange->Start (buf, 1, Add, Sym);
-      exchange->Finish(buf, 1, Add, Sym);
+      exchange->Start (buf, k, Add, trans);
+      exchange->Finish(buf, k, Add, trans);
 
       // copy recv back to device
-      o_buf.copyFrom(buf, exchange->Nhalo,
+      o_buf.copyFrom(buf, exchange->Nhalo*k,
                      0, "async: true");
       device.finish(); //wait for transfer to finish
     }
@@ -105,7 +122,10 @@ static void DeviceExchangeTest(ogsExchange_t* exchange, double time[3]) {
   time[2] = maxTime;      //max
 }
 
-static void HostExchangeTest(ogsExchange_t* exchange, double time[3]) {
+static void HostExchangeTest(ogsExchange_t* exchange,
+                             const int k,
+                             const Transpose trans,
+                             double time[3]) {
   const int Ncold = 10;
   const int Nhot  = 10;
   double localTime, sumTime, minTime, maxTime;
@@ -117,15 +137,15 @@ static void HostExchangeTest(ogsExchange_t* exchange, double time[3]) {
 
   //dry run
   for (int n=0;n<Ncold;++n) {
-    exchange->Start (buf, 1, Add, Sym);
-    exchange->Finish(buf, 1, Add, Sym);
+    exchange->Start (buf, k, Add, trans);
+    exchange->Finish(buf, k, Add, trans);
   }
 
   //hot runs
   timePoint_t start = Time();
   for (int n=0;n<Nhot;++n) {
-    exchange->Start (buf, 1, Add, Sym);
-    exchange->Finish(buf, 1, Add, Sym);
+    exchange->Start (buf, k, Add, trans);
+    exchange->Finish(buf, k, Add, trans);
   }
   timePoint_t end = Time();
 
@@ -139,208 +159,636 @@ static void HostExchangeTest(ogsExchange_t* exchange, double time[3]) {
   time[2] = maxTime;      //max
 }
 
-ogsExchange_t* ogsBase_t::AutoSetup(dlong Nshared,
-                                    memory<parallelNode_t> &sharedNodes,
-                                    ogsOperator_t& _gatherHalo,
-                                    comm_t _comm,
-                                    platform_t &_platform,
-                                    const int verbose) {
+/********************************
+ * AutoSetup cache
+ ********************************/
+static const char* methodNames[] = {"Auto", "Pairwise", "CrystalRouter", "AllToAll",
+                                    "RMA", "SharedMemory", "Hierarchical", "Hybrid"};
+static constexpr int Nmethods = sizeof(methodNames)/sizeof(methodNames[0]);
+
+//method name for reports, with the threshold of Hybrid exchanges
+static std::string MethodName(const Method method, const dlong threshold) {
+  std::string name = methodNames[method];
+  if (method==Hybrid) name += "(" + std::to_string(threshold) + ")";
+  return name;
+}
 
-  int rank, size;
-  rank = comm.rank();
-  size = comm.size();
+static const char* transNames[] = {"Sym", "NoTrans", "Trans"};
 
-  if (size==1) return new ogsPairwise_t(Nshared, sharedNodes,
-                                        _gatherHalo, dataStream,
-                                        comm, platform);
+//cache file name, or empty if caching is disabled
+static std::string AutoCacheFile(platform_t& platform) {
+  settings_t& settings = platform.settings();
 
-  ogsExchange_t* bestExchange;
-  Method method;
-  double bestTime;
+  //only use the cache if the application has registered the ogs settings
+  if (settings.settings.find("OGS AUTO CACHE") == settings.settings.end())
+    return std::string();
 
-#ifdef GPU_AWARE_MPI
-  if (rank==0 && verbose)
-    printf("   Method         Device Exchange (avg, min, max)  Device Exchange (GPU-aware)      Host Exchange \n");
-#else
-  if (rank==0 && verbose)
-    printf("   Method         Device Exchange (avg, min, max)  Host Exchange \n");
-#endif
+  if (settings.compareSetting("OGS AUTO CACHE", "NONE"))
+    return std::string();
 
-  //Trigger JIT kernel builds
-  InitializeKernels(platform, ogs::Dfloat, ogs::Add);
+  return settings.getSetting("OGS AUTO CACHE");
+}
 
-  /********************************
-   * Pairwise
-   ********************************/
-  ogsExchange_t* pairwise = new ogsPairwise_t(Nshared, sharedNodes,
-                                              _gatherHalo, dataStream,
-                                              comm, platform);
+static int AutoRetuneInterval(platform_t& platform) {
+  settings_t& settings = platform.settings();
+  if (settings.settings.find("OGS RETUNE INTERVAL") == settings.settings.end())
+    return 0;
 
-  //standard copy to host - exchange - copy back to device
-  pairwise->gpu_aware=false;
+  int interval=0;
+  settings.getSetting("OGS RETUNE INTERVAL", interval);
+  return interval;
+}
 
-  double pairwiseTime[3];
-  DeviceExchangeTest(pairwise, pairwiseTime);
-  double pairwiseAvg = pairwiseTime[0];
+static bool AutoRetune(platform_t& platform) {
+  settings_t& settings = platform.settings();
+  if (settings.settings.find("OGS AUTO RETUNE") == settings.settings.end())
+    return false;
 
-#ifdef GPU_AWARE_MPI
-  //test GPU-aware exchange
-  pairwise->gpu_aware=true;
+  return settings.compareSetting("OGS AUTO RETUNE", "TRUE");
+}
 
-  double pairwiseGATime[3];
-  DeviceExchangeTest(pairwise, pairwiseGATime);
+//64-bit FNV-1a hash
+static void HashMix(uint64_t& hash, const uint64_t val) {
+  for (int b=0;b<8;++b) {
+    hash ^= (val >> (8*b)) & 0xff;
+    hash *= 1099511628211ULL;
+  }
+}
 
-  if (pairwiseGATime[0] < pairwiseAvg)
-    pairwiseAvg = pairwiseGATime[0];
-  else
-    pairwise->gpu_aware=false;
+static int Log2Bin(const dlong n) {
+  int bin = 0;
+  while ((n >> bin) > 0 && bin < 31) bin++;
+  return bin;
+}
 
-#endif
+/*Signature of an exchange pattern: comm size, ranks per node, and histograms
+  of the halo sizes and message counts over all ranks. Collective.*/
+static uint64_t AutoSignature(dlong Nshared,
+                              memory<parallelNode_t> &sharedNodes,
+                              const dlong Nhalo,
+                              comm_t comm) {
+  const int Nbins = 32;
+  const int rank = comm.rank();
+  const int size = comm.size();
+
+  int ranksPerNode = comm.SplitShared(rank).size();
+  comm.Allreduce(ranksPerNode, comm_t::Max);
+
+  //count the ranks this rank sends messages to
+  memory<int> neighbor(size, 0);
+  for (dlong n=0;n<Nshared;++n) neighbor[sharedNodes[n].rank] = 1;
+
+  dlong Nmessages = 0;
+  for (int r=0;r<size;++r) Nmessages += neighbor[r];
+
+  memory<hlong> histogram(2*Nbins, 0);
+  histogram[Log2Bin(Nhalo)]++;
+  histogram[Nbins+Log2Bin(Nmessages)]++;
+  comm.Allreduce(histogram);
+
+  uint64_t hash = 14695981039346656037ULL;
+  HashMix(hash, size);
+  HashMix(hash, ranksPerNode);
+  for (int n=0;n<2*Nbins;++n) HashMix(hash, histogram[n]);
+  return hash;
+}
+
+//signature of one tuned configuration
+static uint64_t ConfigSignature(const uint64_t signature, const exchangeConfig_t& config) {
+  uint64_t hash = signature;
+  HashMix(hash, config.k);
+  HashMix(hash, config.trans);
+  return hash;
+}
 
-  //test exchange from host memory (just for reporting)
-  double pairwiseHostTime[3];
-  HostExchangeTest(pairwise, pairwiseHostTime);
+/*Look up the configurations in the cache file. Every rank reads the file, and
+  a single collective check confirms all ranks found the same entries.*/
+static bool AutoCacheLookup(const std::string& filename,
+                            const uint64_t signature,
+                            const std::vector<exchangeConfig_t>& configs,
+                            comm_t comm,
+                            std::vector<Method>& methods,
+                            std::vector<bool>& gpu_aware,
+                            std::vector<dlong>& thresholds) {
+  const int Nconfigs = configs.size();
+
+  std::vector<bool> found(Nconfigs, false);
+
+  std::ifstream file(filename);
+  std::string line;
+  while (file.good() && std::getline(file, line)) {
+    std::stringstream ss(line);
+    std::string key, name;
+    int ga;
+    if (!(ss >> key >> name >> ga)) continue;
+
+    //entries written before the Hybrid exchange have no threshold
+    dlong threshold;
+    if (!(ss >> threshold)) threshold = 0;
+
+    for (int c=0;c<Nconfigs;++c) {
+      if (key != std::to_string(ConfigSignature(signature, configs[c]))) continue;
+
+      for (int m=1;m<Nmethods;++m) {
+        if (name == methodNames[m]) {
+          methods[c] = static_cast<Method>(m);
+          gpu_aware[c] = (ga != 0);
+          thresholds[c] = threshold;
+          found[c] = true;
+        }
+      }
+    }
+  }
 
-  bestExchange = pairwise;
-  method = Pairwise;
-  bestTime = pairwiseAvg;
+  //hash of this rank's result, checked for agreement across all ranks
+  bool foundAll = true;
+  uint64_t hash = signature;
+  for (int c=0;c<Nconfigs;++c) {
+    foundAll = foundAll && found[c];
+    HashMix(hash, found[c] ? methods[c] : Nmethods);
+    HashMix(hash, gpu_aware[c]);
+    HashMix(hash, found[c] ? thresholds[c] : 0);
+  }
 
-#ifdef GPU_AWARE_MPI
-  if (rank==0 && verbose)
-    printf("   Pairwise       %5.3e %5.3e %5.3e    %5.3e %5.3e %5.3e    %5.3e %5.3e %5.3e \n",
-            pairwiseTime[0],     pairwiseTime[1],     pairwiseTime[2],
-            pairwiseGATime[0],   pairwiseGATime[1],   pairwiseGATime[2],
-            pairwiseHostTime[0], pairwiseHostTime[1], pairwiseHostTime[2]);
-#else
-  if (rank==0 && verbose)
-    printf("   Pairwise       %5.3e %5.3e %5.3e    %5.3e %5.3e %5.3e \n",
-            pairwiseTime[0],     pairwiseTime[1],     pairwiseTime[2],
-            pairwiseHostTime[0], pairwiseHostTime[1], pairwiseHostTime[2]);
-#endif
+  memory<hlong> check(2);
+  check[0] =  static_cast<hlong>(hash >> 2);
+  check[1] = -static_cast<hlong>(hash >> 2);
+  comm.Allreduce(check, comm_t::Max);
 
-  /********************************
-   * All-to-All
-   ********************************/
-  ogsExchange_t* alltoall = new ogsAllToAll_t(Nshared, sharedNodes,
-                                           _gatherHalo, dataStream,
-                                           comm, platform);
-  //standard copy to host - exchange - copy back to device
-  alltoall->gpu_aware=false;
+  return foundAll && (check[0] == -check[1]);
+}
 
-  double alltoallTime[3];
-  DeviceExchangeTest(alltoall, alltoallTime);
-  double alltoallAvg = alltoallTime[0];
+//record tuning results in the cache file, replacing any stale entries
+static void AutoCacheStore(const std::string& filename,
+                           const uint64_t signature,
+                           const std::vector<exchangeConfig_t>& configs,
+                           const std::vector<Method>& methods,
+                           const std::vector<bool>& gpu_aware,
+                           const std::vector<dlong>& thresholds) {
+  const int Nconfigs = configs.size();
+
+  std::vector<std::string> keys(Nconfigs);
+  for (int c=0;c<Nconfigs;++c)
+    keys[c] = std::to_string(ConfigSignature(signature, configs[c]));
+
+  std::vector<std::string> lines;
+
+  std::ifstream infile(filename);
+  std::string line;
+  while (infile.good() && std::getline(infile, line)) {
+    std::stringstream ss(line);
+    std::string key;
+    ss >> key;
+    if (std::find(keys.begin(), keys.end(), key) == keys.end())
+      lines.push_back(line);
+  }
+  infile.close();
 
-#ifdef GPU_AWARE_MPI
-  //test GPU-aware exchange
-  alltoall->gpu_aware=true;
+  std::ofstream outfile(filename, std::ios::trunc);
+  LIBP_WARNING("Unable to write ogs AutoSetup cache file " << filename,
+               !outfile.good());
+  if (!outfile.good()) return;
 
-  double alltoallGATime[3];
-  DeviceExchangeTest(alltoall, alltoallGATime);
+  for (auto& l : lines) outfile << l << "\n";
+  for (int c=0;c<Nconfigs;++c)
+    outfile << keys[c] << " " << methodNames[methods[c]] << " " << (gpu_aware[c] ? 1 : 0)
+            << " " << thresholds[c] << "\n";
+}
 
-  if (alltoallGATime[0] < alltoallAvg)
-    alltoallAvg = alltoallGATime[0];
-  else
-    alltoall->gpu_aware=false;
+static ogsExchange_t* NewExchange(const Method method,
+                                  dlong Nshared,
+                                  memory<parallelNode_t> &sharedNodes,
+                                  ogsOperator_t& gatherHalo,
+                                  stream_t dataStream,
+                                  comm_t comm,
+                                  platform_t &platform,
+                                  const dlong threshold) {
+  switch (method) {
+    case AllToAll:
+      return new ogsAllToAll_t(Nshared, sharedNodes, gatherHalo, dataStream, comm, platform);
+    case CrystalRouter:
+      return new ogsCrystalRouter_t(Nshared, sharedNodes, gatherHalo, dataStream, comm, platform);
+    case RMA:
+      return new ogsRMA_t(Nshared, sharedNodes, gatherHalo, dataStream, comm, platform);
+    case SharedMemory:
+      return new ogsSharedMemory_t(Nshared, sharedNodes, gatherHalo, dataStream, comm, platform);
+    case Hierarchical:
+      return new ogsHierarchical_t(Nshared, sharedNodes, gatherHalo, dataStream, comm, platform);
+    case Hybrid:
+      return new ogsHybrid_t(Nshared, sharedNodes, gatherHalo, dataStream, comm, platform, threshold);
+    default:
+      return new ogsPairwise_t(Nshared, sharedNodes, gatherHalo, dataStream, comm, platform);
+  }
+}
 
-#endif
+/*Peer size thresholds to try for the Hybrid exchange, spread evenly in log
+  scale between the fewest and most nodes any two ranks share. Empty if all
+  pairs share the same number of nodes, as there is nothing to split. Collective.*/
+static std::vector<dlong> HybridThresholds(dlong Nshared,
+                                           memory<parallelNode_t> &sharedNodes,
+                                           comm_t comm) {
+  const int Ncandidates = 3;
+  const int size = comm.size();
+
+  memory<dlong> peerCounts(size, 0);
+  for (dlong n=0;n<Nshared;++n) peerCounts[sharedNodes[n].rank]++;
+
+  dlong minCount = std::numeric_limits<dlong>::max();
+  dlong maxCount = 0;
+  for (int r=0;r<size;++r) {
+    if (peerCounts[r]==0) continue;
+    minCount = std::min(minCount, peerCounts[r]);
+    maxCount = std::max(maxCount, peerCounts[r]);
+  }
+  comm.Allreduce(minCount, comm_t::Min);
+  comm.Allreduce(maxCount, comm_t::Max);
+
+  std::vector<dlong> thresholds;
+  if (maxCount <= minCount) return thresholds;
+
+  const double ratio = static_cast<double>(maxCount)/minCount;
+  for (int i=1;i<=Ncandidates;++i) {
+    const dlong threshold = static_cast<dlong>(std::ceil(minCount*std::pow(ratio, i/(Ncandidates+1.0))));
+    if (threshold>minCount && threshold<=maxCount
+        && (thresholds.empty() || threshold>thresholds.back()))
+      thresholds.push_back(threshold);
+  }
+  return thresholds;
+}
 
-  //test exchange from host memory (just for reporting)
-  double alltoallHostTime[3];
-  HostExchangeTest(alltoall, alltoallHostTime);
+void ogsBase_t::AutoSetup(dlong Nshared,
+                          memory<parallelNode_t> &sharedNodes,
+                          ogsOperator_t& _gatherHalo,
+                          comm_t _comm,
+                          platform_t &_platform,
+                          const std::vector<exchangeConfig_t>& configs,
+                          const int verbose) {
 
-  if (alltoallAvg < bestTime) {
-    delete bestExchange;
-    bestExchange = alltoall;
-    method = AllToAll;
-    bestTime = alltoallAvg;
-  } else {
-    delete alltoall;
+  int rank, size;
+  rank = comm.rank();
+  size = comm.size();
+
+  tuning = std::make_shared<ogsTuning_t>();
+
+  //tune the symmetric single-component exchange if no configurations are given
+  tuning->configs = configs;
+  if (tuning->configs.size()==0) tuning->configs.push_back({1, Sym});
+
+  const int Nconfigs = tuning->configs.size();
+  tuning->Resize(Nconfigs);
+  tuning->verbose = verbose;
+
+  if (size==1) {
+    exchange = std::shared_ptr<ogsExchange_t>(
+                  new ogsPairwise_t(Nshared, sharedNodes,
+                                    _gatherHalo, dataStream,
+                                    comm, platform));
+    tuning->exchanges.assign(Nconfigs, exchange);
+    return;
   }
 
+  //alternatives are only kept alive if re-tuning is enabled
+  tuning->interval = AutoRetuneInterval(platform);
+  const int Npool = (tuning->interval>0) ? ogsTuning_t::Npool : 0;
+
+  //reuse a previous tuning of this exchange pattern if one is cached
+  std::string cacheFile = AutoCacheFile(platform);
+  uint64_t signature = 0;
+  bool cached = false;
+  if (cacheFile.size()) {
+    signature = AutoSignature(Nshared, sharedNodes, _gatherHalo.NrowsT, comm);
+
+    std::vector<bool> gpu_aware(Nconfigs, false);
+    cached = !AutoRetune(platform)
+             && AutoCacheLookup(cacheFile, signature, tuning->configs,
+                                comm, tuning->methods, gpu_aware,
+                                tuning->thresholds);
 #ifdef GPU_AWARE_MPI
-  if (rank==0 && verbose)
-    printf("   AllToAll       %5.3e %5.3e %5.3e    %5.3e %5.3e %5.3e    %5.3e %5.3e %5.3e \n",
-            alltoallTime[0],     alltoallTime[1],     alltoallTime[2],
-            alltoallGATime[0],   alltoallGATime[1],   alltoallGATime[2],
-            alltoallHostTime[0], alltoallHostTime[1], alltoallHostTime[2]);
-#else
-  if (rank==0 && verbose)
-    printf("   AllToAll       %5.3e %5.3e %5.3e    %5.3e %5.3e %5.3e \n",
-            alltoallTime[0],     alltoallTime[1],     alltoallTime[2],
-            alltoallHostTime[0], alltoallHostTime[1], alltoallHostTime[2]);
+    if (cached) tuning->gpu_aware = gpu_aware;
 #endif
+  }
 
-  /********************************
-   * Crystal Router
-   ********************************/
-  ogsExchange_t* crystal = new ogsCrystalRouter_t(Nshared, sharedNodes,
-                                                 _gatherHalo, dataStream,
-                                                 comm, platform);
-
-  //standard copy to host - exchange - copy back to device
-  crystal->gpu_aware=false;
+  if (cached) {
+    BuildTunedExchanges(Nshared, sharedNodes, _gatherHalo, Npool);
+  } else {
+#ifdef GPU_AWARE_MPI
+    if (rank==0 && verbose)
+      printf("   Method         k  Trans    Device Exchange (avg, min, max)  Device Exchange (GPU-aware)      Host Exchange \n");
+#else
+    if (rank==0 && verbose)
+      printf("   Method         k  Trans    Device Exchange (avg, min, max)  Host Exchange \n");
+#endif
 
-  double crystalTime[3];
-  DeviceExchangeTest(crystal, crystalTime);
-  double crystalAvg = crystalTime[0];
+    //Trigger JIT kernel builds
+    InitializeKernels(platform, ogs::Dfloat, ogs::Add);
+
+    const Method methods[] = {Pairwise, AllToAll, CrystalRouter,
+                              RMA, SharedMemory, Hierarchical};
+
+    //each method once, then the Hybrid exchange at a few thresholds
+    struct trial_t {
+      Method method;
+      dlong threshold;
+    };
+    std::vector<trial_t> trials;
+    for (const Method method : methods) trials.push_back({method, 0});
+    for (const dlong threshold : HybridThresholds(Nshared, sharedNodes, comm))
+      trials.push_back({Hybrid, threshold});
+
+    //per configuration, the fastest exchanges found so far, in order
+    struct ranked_t {
+      double time;
+      std::shared_ptr<ogsExchange_t> exchange;
+      Method method;
+      bool gpu_aware;
+      dlong threshold;
+    };
+    std::vector<std::vector<ranked_t>> ranking(Nconfigs);
+
+    for (const trial_t& trial : trials) {
+      const Method method = trial.method;
+      std::shared_ptr<ogsExchange_t> candidate(
+                          NewExchange(method, Nshared, sharedNodes,
+                                      _gatherHalo, dataStream,
+                                      comm, platform, trial.threshold));
+
+      for (int c=0;c<Nconfigs;++c) {
+        const int k = tuning->configs[c].k;
+        const Transpose trans = tuning->configs[c].trans;
+
+        candidate->AllocBuffer(k*sizeof(dfloat));
+
+        //standard copy to host - exchange - copy back to device
+        candidate->gpu_aware=false;
+
+        double deviceTime[3];
+        DeviceExchangeTest(candidate.get(), k, trans, deviceTime);
+        double avg = deviceTime[0];
+        bool gpu_aware = false;
 
 #ifdef GPU_AWARE_MPI
-  //test GPU-aware exchange
-  crystal->gpu_aware=true;
+        //test GPU-aware exchange
+        candidate->gpu_aware=true;
 
-  double crystalGATime[3];
-  DeviceExchangeTest(crystal, crystalGATime);
-
-  if (crystalGATime[0] < crystalAvg)
-    crystalAvg = crystalGATime[0];
-  else
-    crystal->gpu_aware=false;
+        double deviceGATime[3];
+        DeviceExchangeTest(candidate.get(), k, trans, deviceGATime);
 
+        if (deviceGATime[0] < avg) {
+          avg = deviceGATime[0];
+          gpu_aware = true;
+        }
+        candidate->gpu_aware=false;
 #endif
 
-  //test exchange from host memory (just for reporting)
-  double crystalHostTime[3];
-  HostExchangeTest(crystal, crystalHostTime);
+        //test exchange from host memory (just for reporting)
+        double hostTime[3];
+        HostExchangeTest(candidate.get(), k, trans, hostTime);
 
-  if (crystalAvg < bestTime) {
-    delete bestExchange;
-    bestExchange = crystal;
-    method = CrystalRouter;
-    bestTime = crystalAvg;
-  } else {
-    delete crystal;
-  }
+        //keep the best exchange, and the next best as alternatives
+        std::vector<ranked_t>& rank_c = ranking[c];
+        auto pos = std::find_if(rank_c.begin(), rank_c.end(),
+                                [&](const ranked_t& r) { return avg < r.time; });
+        rank_c.insert(pos, ranked_t{avg, candidate, method, gpu_aware, trial.threshold});
+        if (static_cast<int>(rank_c.size()) > 1+Npool) rank_c.pop_back();
 
 #ifdef GPU_AWARE_MPI
-  if (rank==0 && verbose)
-    printf("   CrystalRouter  %5.3e %5.3e %5.3e    %5.3e %5.3e %5.3e    %5.3e %5.3e %5.3e \n",
-            crystalTime[0],     crystalTime[1],     crystalTime[2],
-            crystalGATime[0],   crystalGATime[1],   crystalGATime[2],
-            crystalHostTime[0], crystalHostTime[1], crystalHostTime[2]);
+        if (rank==0 && verbose)
+          printf("   %-14s %2d %-7s  %5.3e %5.3e %5.3e    %5.3e %5.3e %5.3e    %5.3e %5.3e %5.3e \n",
+                  MethodName(method, trial.threshold).c_str(), k, transNames[trans],
+                  deviceTime[0],   deviceTime[1],   deviceTime[2],
+                  deviceGATime[0], deviceGATime[1], deviceGATime[2],
+                  hostTime[0],     hostTime[1],     hostTime[2]);
 #else
-  if (rank==0 && verbose)
-    printf("   CrystalRouter  %5.3e %5.3e %5.3e    %5.3e %5.3e %5.3e \n",
-            crystalTime[0],     crystalTime[1],     crystalTime[2],
-            crystalHostTime[0], crystalHostTime[1], crystalHostTime[2]);
+        if (rank==0 && verbose)
+          printf("   %-14s %2d %-7s  %5.3e %5.3e %5.3e    %5.3e %5.3e %5.3e \n",
+                  MethodName(method, trial.threshold).c_str(), k, transNames[trans],
+                  deviceTime[0], deviceTime[1], deviceTime[2],
+                  hostTime[0],   hostTime[1],   hostTime[2]);
 #endif
+      }
+    }
+
+    for (int c=0;c<Nconfigs;++c) {
+      tuning->exchanges[c] = ranking[c][0].exchange;
+      tuning->methods[c]   = ranking[c][0].method;
+      tuning->gpu_aware[c] = ranking[c][0].gpu_aware;
+      tuning->thresholds[c] = ranking[c][0].threshold;
+
+      for (size_t n=1;n<ranking[c].size();++n) {
+        tuning->pool[c].push_back(ranking[c][n].exchange);
+        tuning->poolMethods[c].push_back(ranking[c][n].method);
+        tuning->poolGpuAware[c].push_back(ranking[c][n].gpu_aware);
+        tuning->poolThresholds[c].push_back(ranking[c][n].threshold);
+      }
+    }
+
+    if (cacheFile.size() && rank==0)
+      AutoCacheStore(cacheFile, signature, tuning->configs,
+                     tuning->methods, tuning->gpu_aware,
+                     tuning->thresholds);
+  }
 
   if (rank==0 && verbose) {
-    switch (method) {
-      case AllToAll:
-        printf("   Exchange method selected: AllToAll"); break;
-      case Pairwise:
-        printf("   Exchange method selected: Pairwise"); break;
-      case CrystalRouter:
-        printf("   Exchange method selected: CrystalRouter"); break;
-      default:
-        break;
+    for (int c=0;c<Nconfigs;++c) {
+      printf("   Exchange method selected (k=%d, %s): %s",
+             tuning->configs[c].k, transNames[tuning->configs[c].trans],
+             MethodName(tuning->methods[c], tuning->thresholds[c]).c_str());
+      if (tuning->gpu_aware[c]) printf(" (GPU-aware)");
+      if (cached) printf(" (cached)");
+      printf("\n");
+    }
+  }
+
+  //the first configuration is the default exchange
+  exchange = tuning->exchanges[0];
+  exchange->gpu_aware = tuning->gpu_aware[0];
+}
+
+//Build the exchange methods in tuning->methods, each once, along with the
+// default alternatives for re-trials, without benchmarking
+void ogsBase_t::BuildTunedExchanges(dlong Nshared,
+                                    memory<parallelNode_t> &sharedNodes,
+                                    ogsOperator_t& _gatherHalo,
+                                    const int Npool) {
+  const int Nconfigs = tuning->configs.size();
+
+  //build each method (and Hybrid threshold) once, and the default
+  // alternatives for re-trials
+  std::map<std::pair<Method,dlong>, std::shared_ptr<ogsExchange_t>> built;
+  const Method alternatives[] = {Pairwise, CrystalRouter, AllToAll};
+
+  for (int c=0;c<Nconfigs;++c) {
+    const Method method = tuning->methods[c];
+    const dlong threshold = (method==Hybrid) ? tuning->thresholds[c] : 0;
+    std::shared_ptr<ogsExchange_t>& exchange_c = built[{method, threshold}];
+    if (!exchange_c) {
+      exchange_c = std::shared_ptr<ogsExchange_t>(
+                        NewExchange(method, Nshared, sharedNodes,
+                                    _gatherHalo, dataStream,
+                                    comm, platform, threshold));
+    }
+    tuning->exchanges[c] = exchange_c;
+
+    for (const Method alt : alternatives) {
+      if (static_cast<int>(tuning->pool[c].size()) == Npool) break;
+      if (alt == method) continue;
+
+      std::shared_ptr<ogsExchange_t>& exchange_alt = built[{alt, 0}];
+      if (!exchange_alt) {
+        exchange_alt = std::shared_ptr<ogsExchange_t>(
+                        NewExchange(alt, Nshared, sharedNodes,
+                                    _gatherHalo, dataStream,
+                                    comm, platform, 0));
+      }
+      tuning->pool[c].push_back(exchange_alt);
+      tuning->poolMethods[c].push_back(alt);
+      tuning->poolGpuAware[c].push_back(false);
+      tuning->poolThresholds[c].push_back(0);
     }
-    if (bestExchange->gpu_aware) printf(" (GPU-aware)");
-    printf("\n");
   }
+}
+
+//Rebuild the tuned exchanges for a new shared node list, keeping the
+// methods selected when the handle was set up
+void ogsBase_t::RebuildExchanges(dlong Nshared,
+                                 memory<parallelNode_t> &sharedNodes,
+                                 ogsOperator_t& _gatherHalo) {
+
+  std::shared_ptr<ogsTuning_t> old = tuning;
+
+  tuning = std::make_shared<ogsTuning_t>();
+  tuning->configs = old->configs;
+
+  const int Nconfigs = tuning->configs.size();
+  tuning->Resize(Nconfigs);
+  tuning->verbose = old->verbose;
+  tuning->interval = old->interval;
+  tuning->methods = old->methods;
+  tuning->gpu_aware = old->gpu_aware;
+  tuning->thresholds = old->thresholds;
+
+  const int Npool = (tuning->interval>0) ? ogsTuning_t::Npool : 0;
+  BuildTunedExchanges(Nshared, sharedNodes, _gatherHalo, Npool);
+
+  exchange = tuning->exchanges[0];
+  exchange->gpu_aware = tuning->gpu_aware[0];
+}
+
+/********************************
+ * Online re-tuning
+ ********************************/
+void ogsTuning_t::Resize(const int Nconfigs) {
+  exchanges.assign(Nconfigs, nullptr);
+  methods.assign(Nconfigs, Pairwise);
+  gpu_aware.assign(Nconfigs, false);
+  thresholds.assign(Nconfigs, 0);
+
+  pool.assign(Nconfigs, {});
+  poolMethods.assign(Nconfigs, {});
+  poolGpuAware.assign(Nconfigs, {});
+  poolThresholds.assign(Nconfigs, {});
+
+  Nstarts.assign(Nconfigs, 0);
+  Ncalls.assign(Nconfigs, 0);
+  elapsed.assign(Nconfigs, 0.0);
+  Nwins.assign(Nconfigs, 0);
+  winner.assign(Nconfigs, -1);
+}
+
+//the re-trial itself is run by the handle once RetuneDue, when the next
+// operation of this configuration starts
+void ogsTuning_t::Record(const int c, const double time, const bool finish) {
+  elapsed[c] += time;
+  if (finish) Ncalls[c]++;
+  else        Nstarts[c]++;
+}
+
+/*Collectively re-trial the current exchange of a configuration against its
+  alternatives, and switch once an alternative has been consistently faster*/
+void ogsTuning_t::Retune(const int c) {
+
+  if (pool[c].size()>0) {
+    ogsExchange_t* current = exchanges[c].get();
+    comm_t& comm = current->comm;
+    const int k = configs[c].k;
+    const Transpose trans = configs[c].trans;
+
+    //the exchange buffers may still be in use by queued work
+    current->platform.device.finish();
+
+    //average live Start+Finish time since the last re-trial
+    double liveTime = (Ncalls[c]>0) ? elapsed[c]/Ncalls[c] : 0.0;
+    comm.Allreduce(liveTime, comm_t::Max);
+
+    const int Ncold = 2;
+    const int Nhot  = 5;
+
+    current->AllocBuffer(k*sizeof(dfloat));
+    current->gpu_aware = gpu_aware[c];
+
+    double currentTime[3];
+    DeviceExchangeTest(current, k, trans, currentTime, Ncold, Nhot);
+
+    int best = -1;
+    double bestTime = (1.0-margin)*currentTime[0];
+    for (size_t p=0;p<pool[c].size();++p) {
+      ogsExchange_t* alt = pool[c][p].get();
+      alt->AllocBuffer(k*sizeof(dfloat));
+      alt->gpu_aware = poolGpuAware[c][p];
+
+      double altTime[3];
+      DeviceExchangeTest(alt, k, trans, altTime, Ncold, Nhot);
+      if (altTime[0] < bestTime) {
+        best = p;
+        bestTime = altTime[0];
+      }
+    }
+
+    //only count a run of wins by the same alternative
+    if (best<0)              Nwins[c] = 0;
+    else if (best==winner[c]) Nwins[c]++;
+    else                     Nwins[c] = 1;
+    winner[c] = best;
+
+    if (Nwins[c]>=Nconsistent) {
+      if (comm.rank()==0 && verbose)
+        printf("   ogs re-tune (k=%d, %s): %s -> %s (live %5.3e, trial %5.3e -> %5.3e)\n",
+               k, transNames[trans],
+               MethodName(methods[c], thresholds[c]).c_str(),
+               MethodName(poolMethods[c][best], poolThresholds[c][best]).c_str(),
+               liveTime, currentTime[0], bestTime);
+
+      std::swap(exchanges[c], pool[c][best]);
+      std::swap(methods[c],   poolMethods[c][best]);
+      bool ga = gpu_aware[c];
+      gpu_aware[c] = poolGpuAware[c][best];
+      poolGpuAware[c][best] = ga;
+      std::swap(thresholds[c], poolThresholds[c][best]);
+
+      Nwins[c] = 0;
+      winner[c] = -1;
+    }
+  }
+
+  Nstarts[c] = 0;
+  Ncalls[c] = 0;
+  elapsed[c] = 0.0;
+}
+
+exchangeTimer_t::exchangeTimer_t(std::shared_ptr<ogsTuning_t> _tuning,
+                                 std::shared_ptr<ogsExchange_t> _exchange,
+                                 const int _config,
+                                 const bool _finish):
+  tuning(_tuning), exchange(_exchange), config(_config), finish(_finish) {
+  if (!finish) ProgressBegin();
+  if (!finish && exchange) exchange->RecordStart();
+  if (tuning) start = Time();
+}
 
-  return bestExchange;
+exchangeTimer_t::~exchangeTimer_t() {
+  if (tuning) tuning->Record(config, ElapsedTime(start, Time()), finish);
+  if (finish && exchange) exchange->RecordFinish();
+  if (finish) ProgressEnd();
 }
 
 
@@ -42,67 +42,116 @@ namespace ogs {
 /**********************************
 * Host exchange
 ***********************************/
+// At each level the current halo data is in h_workspace, and the partner's
+// data is received into the same buffer past recvOffset.
 template<typename T>
-inline void ogsCrystalRouter_t::Start(pinnedMemory<T> &buf, const int k,
-                               const Op op, const Transpose trans){}
+void ogsCrystalRouter_t::HostPost(const int l) {
+  memory<crLevel> levels = Levels();
+  const int k = kFlight;
+
+  pinnedMemory<T> buf = h_workspace;
+  pinnedMemory<T> sendBuf = h_sendspace;
+
+  //post recvs
+  if (levels[l].Nmsg>0) {
+    comm.Irecv(buf + levels[l].recvOffset*k,
+               levels[l].partner,
+               k*levels[l].Nrecv0,
+               levels[l].partner+tagOffset,
+               request[1]);
+  }
+  if (levels[l].Nmsg==2) {
+    comm.Irecv(buf + levels[l].recvOffset*k + levels[l].Nrecv0*k,
+              rank-1,
+              k*levels[l].Nrecv1,
+              rank-1+tagOffset,
+              request[2]);
+  }
+
+  //assemble send buffer
+  extract(levels[l].Nsend, k, levels[l].sendIds, buf, sendBuf);
+
+  //post send
+  comm.Isend(sendBuf,
+             levels[l].partner,
+             k*levels[l].Nsend,
+             rank+tagOffset,
+             request[0]);
+  RecordSend(levels[l].partner, k*levels[l].Nsend*sizeof(T));
+}
 
 template<typename T>
-inline void ogsCrystalRouter_t::Finish(pinnedMemory<T> &buf, const int k,
-                                const Op op, const Transpose trans){
+void ogsCrystalRouter_t::HostComplete(const int l) {
+  memory<crLevel> levels = Levels();
 
+  timePoint_t wait = Time();
+  comm.Waitall(levels[l].Nmsg+1, request);
+  RecordWait(wait);
 
-  memory<crLevel> levels;
-  if (trans==NoTrans) {
-    levels = levelsN;
-  } else {
-    levels = levelsT;
-  }
+  //rotate buffers
+  pinnedMemory<T> recvBuf = h_workspace;
+  h_workspace = h_work[(hbuf_id+1)%2];
+  hbuf_id = (hbuf_id+1)%2;
 
-  pinnedMemory<T> sendBuf = h_sendspace;
+  pinnedMemory<T> buf = h_workspace;
+
+  //Gather the recv'd values into the haloBuffer
+  levels[l].gather.Gather(buf, recvBuf, kFlight, opFlight, Trans);
+}
+
+template<typename T>
+inline void ogsCrystalRouter_t::Start(pinnedMemory<T> &buf, const int k,
+                               const Op op, const Transpose trans){
 
   // To start,    buf = h_workspace = h_work[(hbuf_id+0)%2];
   //          sendBuf = h_sendspace;
-  for (int l=0;l<Nlevels;l++) {
-    pinnedMemory<T> recvBuf = h_workspace;
-
-    //post recvs
-    if (levels[l].Nmsg>0) {
-      comm.Irecv(recvBuf + levels[l].recvOffset*k,
-                 levels[l].partner,
-                 k*levels[l].Nrecv0,
-                 levels[l].partner,
-                 request[1]);
-    }
-    if (levels[l].Nmsg==2) {
-      comm.Irecv(recvBuf + levels[l].recvOffset*k + levels[l].Nrecv0*k,
-                rank-1,
-                k*levels[l].Nrecv1,
-                rank-1,
-                request[2]);
-    }
+  kFlight = k;
+  opFlight = op;
+  transFlight = trans;
+  typeFlight = ogsType<T>::get();
+  onDevice = false;
+
+  //post the first level, later levels follow in Progress or Finish
+  level = 0;
+  posted = true;
+  inFlight = (Nlevels>0);
+  if (inFlight) HostPost<T>(level);
+}
 
-    //assemble send buffer
-    extract(levels[l].Nsend, k, levels[l].sendIds, buf, sendBuf);
+template<typename T>
+void ogsCrystalRouter_t::HostProgress() {
+  memory<crLevel> levels = Levels();
 
-    //post send
-    comm.Isend(sendBuf,
-               levels[l].partner,
-               k*levels[l].Nsend,
-               rank,
-               request[0]);
+  //advance through any levels whose messages have arrived
+  while (inFlight && comm.Testall(levels[level].Nmsg+1, request)) {
+    HostComplete<T>(level);
 
-    comm.Waitall(levels[l].Nmsg+1, request);
+    level++;
+    if (level<Nlevels) {
+      HostPost<T>(level);
+    } else {
+      inFlight = false;
+    }
+  }
+}
 
-    //rotate buffers
-    h_workspace = h_work[(hbuf_id+1)%2];
-    hbuf_id = (hbuf_id+1)%2;
+template<typename T>
+inline void ogsCrystalRouter_t::Finish(pinnedMemory<T> &buf, const int k,
+                                const Op op, const Transpose trans){
 
-    recvBuf = buf;
-    buf     = h_workspace;
+  while (inFlight) {
+    HostComplete<T>(level);
 
-    //Gather the recv'd values into the haloBuffer
-    levels[l].gather.Gather(buf, recvBuf, k, op, Trans);
+    level++;
+    if (level<Nlevels) {
+      HostPost<T>(level);
+    } else {
+      inFlight = false;
+    }
   }
+
+  posted = false;
+  buf = h_workspace;
 }
 
 void ogsCrystalRouter_t::Start(pinnedMemory<float> &buf, const int k, const Op op, const Transpose trans) { Start<float>(buf, k, op, trans); }
@@ -117,19 +166,90 @@ void ogsCrystalRouter_t::Finish(pinnedMemory<long long int> &buf, const int k, c
 /**********************************
 * GPU-aware exchange
 ***********************************/
+template<typename T>
+void ogsCrystalRouter_t::DevicePost(const int l) {
+  memory<crLevel> levels = Levels();
+  const int k = kFlight;
+
+  deviceMemory<T> o_buf = o_workspace;
+  deviceMemory<T> o_sendBuf = o_sendspace;
+
+  //post recvs
+  if (levels[l].Nmsg>0) {
+    comm.Irecv(o_buf + levels[l].recvOffset*k,
+               levels[l].partner,
+               k*levels[l].Nrecv0,
+               levels[l].partner+tagOffset,
+               request[1]);
+  }
+  if (levels[l].Nmsg==2) {
+    comm.Irecv(o_buf + levels[l].recvOffset*k + levels[l].Nrecv0*k,
+              rank-1,
+              k*levels[l].Nrecv1,
+              rank-1+tagOffset,
+              request[2]);
+  }
+
+  //assemble send buffer
+  if (levels[l].Nsend) {
+    extractKernel[ogsType<T>::get()](levels[l].Nsend, k,
+                                     levels[l].o_sendIds,
+                                     o_buf, o_sendBuf);
+    platform.device.finish();
+  }
+
+  //post send
+  comm.Isend(o_sendBuf,
+             levels[l].partner,
+             k*levels[l].Nsend,
+             rank+tagOffset,
+             request[0]);
+  RecordSend(levels[l].partner, k*levels[l].Nsend*sizeof(T));
+}
+
+template<typename T>
+void ogsCrystalRouter_t::DeviceComplete(const int l) {
+  memory<crLevel> levels = Levels();
+
+  timePoint_t wait = Time();
+  comm.Waitall(levels[l].Nmsg+1, request);
+  RecordWait(wait);
+
+  //rotate buffers
+  deviceMemory<T> o_recvBuf = o_workspace;
+  o_workspace = o_work[(buf_id+1)%2];
+  buf_id = (buf_id+1)%2;
+
+  deviceMemory<T> o_buf = o_workspace;
+
+  //Gather the recv'd values into the haloBuffer
+  levels[l].gather.Gather(o_buf, o_recvBuf, kFlight, opFlight, Trans);
+}
+
 template<typename T>
 inline void ogsCrystalRouter_t::Start(deviceMemory<T> &o_buf,
                                       const int k,
                                       const Op op,
                                       const Transpose trans){
+
+  // To start,    o_buf = o_workspace = o_work[(buf_id+0)%2];
+  //          o_sendBuf = o_sendspace
+  kFlight = k;
+  opFlight = op;
+  transFlight = trans;
+  typeFlight = ogsType<T>::get();
+  onDevice = true;
+
+  //post the first level on the current stream, so the send buffer is
+  // extracted after o_buf is ready. Later levels follow in Progress or Finish
+  level = 0;
+  posted = true;
+  inFlight = (Nlevels>0);
+  if (inFlight) DevicePost<T>(level);
 }
 
 template<typename T>
-inline void ogsCrystalRouter_t::Finish(deviceMemory<T> &o_buf,
-                                       const int k,
-                                       const Op op,
-                                       const Transpose trans){
-
+void ogsCrystalRouter_t::DeviceProgress() {
   device_t &device = platform.device;
 
   //get current stream
@@ -138,65 +258,52 @@ inline void ogsCrystalRouter_t::Finish(deviceMemory<T> &o_buf,
   //the intermediate kernels are always overlapped with the default stream
   device.setStream(dataStream);
 
-  memory<crLevel> levels;
-  if (trans==NoTrans) {
-    levels = levelsN;
-  } else {
-    levels = levelsT;
-  }
+  memory<crLevel> levels = Levels();
 
-  deviceMemory<T> o_sendBuf = o_sendspace;
+  //advance through any levels whose messages have arrived
+  while (inFlight && comm.Testall(levels[level].Nmsg+1, request)) {
+    DeviceComplete<T>(level);
 
-  // To start,    o_buf = o_workspace = o_work[(buf_id+0)%2];
-  //          o_sendBuf = o_sendspace
-  for (int l=0;l<Nlevels;l++) {
-    deviceMemory<T> o_recvBuf = o_workspace;
-
-    //post recvs
-    if (levels[l].Nmsg>0) {
-      comm.Irecv(o_recvBuf + levels[l].recvOffset*k,
-                 levels[l].partner,
-                 k*levels[l].Nrecv0,
-                 levels[l].partner,
-                 request[1]);
-    }
-    if (levels[l].Nmsg==2) {
-      comm.Irecv(o_recvBuf + levels[l].recvOffset*k + levels[l].Nrecv0*k,
-                rank-1,
-                k*levels[l].Nrecv1,
-                rank-1,
-                request[2]);
+    level++;
+    if (level<Nlevels) {
+      DevicePost<T>(level);
+    } else {
+      inFlight = false;
     }
+  }
 
-    //assemble send buffer
-    if (levels[l].Nsend) {
-      extractKernel[ogsType<T>::get()](levels[l].Nsend, k,
-                                       levels[l].o_sendIds,
-                                       o_buf, o_sendBuf);
-      device.finish();
-    }
+  device.setStream(currentStream);
+}
 
-    //post send
-    comm.Isend(o_sendBuf,
-               levels[l].partner,
-               k*levels[l].Nsend,
-               rank,
-               request[0]);
+template<typename T>
+inline void ogsCrystalRouter_t::Finish(deviceMemory<T> &o_buf,
+                                       const int k,
+                                       const Op op,
+                                       const Transpose trans){
 
-    comm.Waitall(levels[l].Nmsg+1, request);
+  device_t &device = platform.device;
 
-    //rotate buffers
-    o_workspace = o_work[(buf_id+1)%2];
-    buf_id = (buf_id+1)%2;
+  //get current stream
+  stream_t currentStream = device.getStream();
 
-    o_recvBuf = o_buf;
-    o_buf  = o_workspace;
+  //the intermediate kernels are always overlapped with the default stream
+  device.setStream(dataStream);
+
+  while (inFlight) {
+    DeviceComplete<T>(level);
 
-    //Gather the recv'd values into the haloBuffer
-    levels[l].gather.Gather(o_buf, o_recvBuf, k, op, Trans);
+    level++;
+    if (level<Nlevels) {
+      DevicePost<T>(level);
+    } else {
+      inFlight = false;
+    }
   }
 
   device.setStream(currentStream);
+
+  posted = false;
+  o_buf = o_workspace;
 }
 
 void ogsCrystalRouter_t::Start(deviceMemory<float> &buf, const int k, const Op op, const Transpose trans) { Start<float>(buf, k, op, trans); }
@@ -208,6 +315,32 @@ void ogsCrystalRouter_t::Finish(deviceMemory<double> &buf, const int k, const Op
 void ogsCrystalRouter_t::Finish(deviceMemory<int> &buf, const int k, const Op op, const Transpose trans) { Finish<int>(buf, k, op, trans); }
 void ogsCrystalRouter_t::Finish(deviceMemory<long long int> &buf, const int k, const Op op, const Transpose trans) { Finish<long long int>(buf, k, op, trans); }
 
+/**********************************
+* Polling hook
+***********************************/
+void ogsCrystalRouter_t::Progress() {
+  if (!inFlight) return;
+
+  if (onDevice) {
+    switch (typeFlight) {
+      case Float:  DeviceProgress<float>(); break;
+      case Double: DeviceProgress<double>(); break;
+      case Int32:  DeviceProgress<int>(); break;
+      case Int64:  DeviceProgress<long long int>(); break;
+    }
+  } else {
+    switch (typeFlight) {
+      case Float:  HostProgress<float>(); break;
+      case Double: HostProgress<double>(); break;
+      case Int32:  HostProgress<int>(); break;
+      case Int64:  HostProgress<long long int>(); break;
+    }
+  }
+}
+
+bool ogsCrystalRouter_t::Ready() {
+  return posted && !inFlight;
+}
 
 /*
  *Crystal Router performs the needed MPI communcation via recursive
@@ -770,6 +903,25 @@ void ogsCrystalRouter_t::AllocBuffer(size_t Nbytes) {
   }
 }
 
+ogsExchange_t* ogsCrystalRouter_t::Clone() {
+  ogsCrystalRouter_t* clone = new ogsCrystalRouter_t(*this);
+
+  //private buffers and requests, allocated on first use
+  for (int n=0;n<2;n++) {
+    clone->h_work[n] = pinnedMemory<char>();
+    clone->o_work[n] = deviceMemory<char>();
+  }
+  clone->h_workspace = pinnedMemory<char>();
+  clone->o_workspace = deviceMemory<char>();
+  clone->h_sendspace = pinnedMemory<char>();
+  clone->o_sendspace = deviceMemory<char>();
+  clone->request.malloc(3);
+
+  clone->posted = false;
+  clone->inFlight = false;
+  return clone;
+}
+
 } //namespace ogs
 
 } //namespace libp
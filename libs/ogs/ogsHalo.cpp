@@ -44,11 +44,20 @@ void halo_t::Exchange(deviceMemory<T> o_v, const int k) {
 
 template<typename T>
 void halo_t::ExchangeStart(deviceMemory<T> o_v, const int k){
+  exchangeTimer_t timer = SelectExchange(k, NoTrans);
+
+  if constexpr (std::is_same<T, double>::value) {
+    if (reduced_precision) {
+      ReducedExchangeStart(o_v, k);
+      return;
+    }
+  }
+
   exchange->AllocBuffer(k*sizeof(T));
 
   deviceMemory<T> o_haloBuf = exchange->o_workspace;
 
-  if (exchange->gpu_aware) {
+  if (exchange->gpu_aware || exchange->staged) {
     if (gathered_halo) {
       //if this halo was build from a gathered ogs the halo nodes are at the end
       o_haloBuf.copyFrom(o_v + k*NlocalT, k*NhaloP,
@@ -58,8 +67,13 @@ void halo_t::ExchangeStart(deviceMemory<T> o_v, const int k){
       gatherHalo->Gather(o_haloBuf, o_v, k, Add, NoTrans);
     }
 
-    //prepare MPI exchange
-    exchange->Start(o_haloBuf, k, Add, NoTrans);
+    if (exchange->gpu_aware) {
+      //prepare MPI exchange
+      exchange->Start(o_haloBuf, k, Add, NoTrans);
+    } else {
+      //stage the exchange through the host peer by peer
+      exchange->StagedStart(o_haloBuf, k, Add, NoTrans);
+    }
 
   } else {
     //get current stream
@@ -70,25 +84,27 @@ void halo_t::ExchangeStart(deviceMemory<T> o_v, const int k){
     pinnedMemory<T> haloBuf = exchange->h_workspace;
 
     if (gathered_halo) {
-      //wait for o_v to be ready
-      device.finish();
+      //wait for the work producing o_v
+      device.waitFor(device.tagStream());
 
-      //queue copy to host
+      //queue copy to host, and tag its completion
       device.setStream(dataStream);
       haloBuf.copyFrom(o_v + k*NlocalT, NhaloP*k,
                        0, "async: true");
+      dataTag = device.tagStream();
       device.setStream(currentStream);
     } else {
       //collect halo buffer
       gatherHalo->Gather(o_haloBuf, o_v, k, Add, NoTrans);
 
-      //wait for o_haloBuf to be ready
-      device.finish();
+      //wait for the work producing o_haloBuf
+      device.waitFor(device.tagStream());
 
-      //queue copy to host
+      //queue copy to host, and tag its completion
       device.setStream(dataStream);
       haloBuf.copyFrom(o_haloBuf, NhaloP*k,
                        0, "async: true");
+      dataTag = device.tagStream();
       device.setStream(currentStream);
     }
   }
@@ -96,13 +112,27 @@ void halo_t::ExchangeStart(deviceMemory<T> o_v, const int k){
 
 template<typename T>
 void halo_t::ExchangeFinish(deviceMemory<T> o_v, const int k){
+  exchangeTimer_t timer = SelectExchange(k, NoTrans, /*finish=*/true);
+
+  if constexpr (std::is_same<T, double>::value) {
+    if (reduced_precision) {
+      ReducedExchangeFinish(o_v, k);
+      return;
+    }
+  }
+
 
   deviceMemory<T> o_haloBuf = exchange->o_workspace;
 
   //write exchanged halo buffer back to vector
-  if (exchange->gpu_aware) {
-    //finish MPI exchange
-    exchange->Finish(o_haloBuf, k, Add, NoTrans);
+  if (exchange->gpu_aware || exchange->staged) {
+    if (exchange->gpu_aware) {
+      //finish MPI exchange
+      exchange->Finish(o_haloBuf, k, Add, NoTrans);
+    } else {
+      //copy received chunks back as they arrive
+      exchange->StagedFinish(o_haloBuf, k, Add, NoTrans);
+    }
 
     if (gathered_halo) {
       o_haloBuf.copyTo(o_v + k*(NlocalT+NhaloP), k*Nhalo,
@@ -113,39 +143,42 @@ void halo_t::ExchangeFinish(deviceMemory<T> o_v, const int k){
   } else {
     pinnedMemory<T> haloBuf = exchange->h_workspace;
 
-    //get current stream
     device_t &device = platform.device;
-    stream_t currentStream = device.getStream();
 
-    //synchronize data stream to ensure the buffer is on the host
-    device.setStream(dataStream);
-    device.finish();
+    //wait for the copy of the halo buffer to the host
+    device.waitFor(dataTag);
 
     /*MPI exchange of host buffer*/
     exchange->Start (haloBuf, k, Add, NoTrans);
     exchange->Finish(haloBuf, k, Add, NoTrans);
 
-    // copy recv back to device
+    // copy recv back to device, ordered before later work on the current stream
     if (gathered_halo) {
       haloBuf.copyTo(o_v + k*(NlocalT+NhaloP), k*Nhalo,
                      k*NhaloP, "async: true");
-      device.finish(); //wait for transfer to finish
-      device.setStream(currentStream);
     } else {
       haloBuf.copyTo(o_haloBuf+k*NhaloP, k*Nhalo,
                      k*NhaloP, "async: true");
-      device.finish(); //wait for transfer to finish
-      device.setStream(currentStream);
 
       gatherHalo->Scatter(o_v, o_haloBuf, k, NoTrans);
     }
   }
 }
 
+template<typename T>
+ogsFuture_t halo_t::ExchangeAsync(deviceMemory<T> o_v, const int k){
+  return Launch([=]() { ExchangeStart (o_v, k); },
+                [=]() { ExchangeFinish(o_v, k); });
+}
+
 template void halo_t::Exchange(deviceMemory<float> o_v, const int k);
 template void halo_t::Exchange(deviceMemory<double> o_v, const int k);
 template void halo_t::Exchange(deviceMemory<int> o_v, const int k);
 template void halo_t::Exchange(deviceMemory<long long int> o_v, const int k);
+template ogsFuture_t halo_t::ExchangeAsync(deviceMemory<float> o_v, const int k);
+template ogsFuture_t halo_t::ExchangeAsync(deviceMemory<double> o_v, const int k);
+template ogsFuture_t halo_t::ExchangeAsync(deviceMemory<int> o_v, const int k);
+template ogsFuture_t halo_t::ExchangeAsync(deviceMemory<long long int> o_v, const int k);
 
 //host version
 template<typename T>
@@ -156,6 +189,15 @@ void halo_t::Exchange(memory<T> v, const int k) {
 
 template<typename T>
 void halo_t::ExchangeStart(memory<T> v, const int k) {
+  exchangeTimer_t timer = SelectExchange(k, NoTrans);
+
+  if constexpr (std::is_same<T, double>::value) {
+    if (reduced_precision) {
+      ReducedExchangeStart(v, k);
+      return;
+    }
+  }
+
   exchange->AllocBuffer(k*sizeof(T));
 
   pinnedMemory<T> haloBuf = exchange->h_workspace;
@@ -174,6 +216,15 @@ void halo_t::ExchangeStart(memory<T> v, const int k) {
 
 template<typename T>
 void halo_t::ExchangeFinish(memory<T> v, const int k) {
+  exchangeTimer_t timer = SelectExchange(k, NoTrans, /*finish=*/true);
+
+  if constexpr (std::is_same<T, double>::value) {
+    if (reduced_precision) {
+      ReducedExchangeFinish(v, k);
+      return;
+    }
+  }
+
 
   pinnedMemory<T> haloBuf = exchange->h_workspace;
 
@@ -196,6 +247,291 @@ template void halo_t::Exchange(memory<double> v, const int k);
 template void halo_t::Exchange(memory<int> v, const int k);
 template void halo_t::Exchange(memory<long long int> v, const int k);
 
+/********************************
+ * Aggregated Exchange
+ ********************************/
+void halo_t::Exchange(std::vector<haloField_t>& fields) {
+  ExchangeStart (fields);
+  ExchangeFinish(fields);
+}
+
+void halo_t::ExchangeStart(std::vector<haloField_t>& fields){
+  //words per node over all fields
+  int K=0;
+  for (auto& f : fields) K += f.k;
+  if (K==0) return;
+
+  exchangeTimer_t timer = SelectExchange(K, NoTrans);
+
+  //the fields are exchanged as raw 32-bit words. Each flagged node has a
+  // sole unflagged source, so adding onto zero copies the bits exactly
+  InitializeKernels(platform, Int32, Add);
+
+  exchange->AllocBuffer(K*sizeof(int));
+
+  deviceMemory<int> o_haloBuf = exchange->o_workspace;
+
+  int kmax=0;
+  for (auto& f : fields) kmax = std::max(kmax, f.k);
+  if (!gathered_halo
+      && o_fieldBuf.length() < static_cast<size_t>(kmax)*(NhaloP+Nhalo)) {
+    o_fieldBuf = platform.malloc<int>(kmax*(NhaloP+Nhalo));
+  }
+
+  //pack the halo values of every field into one buffer, K words per node
+  int offset=0;
+  for (auto& f : fields) {
+    deviceMemory<int> o_src;
+    if (gathered_halo) {
+      //if this halo was build from a gathered ogs the halo nodes are at the end
+      o_src = f.o_v + f.k*NlocalT;
+    } else {
+      //collect halo buffer of this field
+      gatherHalo->Gather(o_fieldBuf, f.o_v, f.k, Add, NoTrans);
+      o_src = o_fieldBuf;
+    }
+    if (NhaloP) {
+      ogsExchange_t::packFieldsKernel(NhaloP, K, offset, f.k, o_src, o_haloBuf);
+    }
+    offset += f.k;
+  }
+
+  if (exchange->gpu_aware) {
+    //prepare MPI exchange
+    exchange->Start(o_haloBuf, K, Add, NoTrans);
+  } else if (exchange->staged) {
+    //stage the exchange through the host peer by peer
+    exchange->StagedStart(o_haloBuf, K, Add, NoTrans);
+  } else {
+    //get current stream
+    device_t &device = platform.device;
+    stream_t currentStream = device.getStream();
+
+    //if not using gpu-aware mpi move the halo buffer to the host
+    pinnedMemory<int> haloBuf = exchange->h_workspace;
+
+    //wait for the work producing o_haloBuf
+    device.waitFor(device.tagStream());
+
+    //queue copy to host, and tag its completion
+    device.setStream(dataStream);
+    haloBuf.copyFrom(o_haloBuf, NhaloP*K,
+                     0, "async: true");
+    dataTag = device.tagStream();
+    device.setStream(currentStream);
+  }
+}
+
+void halo_t::ExchangeFinish(std::vector<haloField_t>& fields){
+  int K=0;
+  for (auto& f : fields) K += f.k;
+  if (K==0) return;
+
+  exchangeTimer_t timer = SelectExchange(K, NoTrans, /*finish=*/true);
+
+  deviceMemory<int> o_haloBuf = exchange->o_workspace;
+
+  if (exchange->gpu_aware) {
+    //finish MPI exchange
+    exchange->Finish(o_haloBuf, K, Add, NoTrans);
+  } else if (exchange->staged) {
+    //copy received chunks back as they arrive
+    exchange->StagedFinish(o_haloBuf, K, Add, NoTrans);
+  } else {
+    pinnedMemory<int> haloBuf = exchange->h_workspace;
+
+    device_t &device = platform.device;
+
+    //wait for the copy of the halo buffer to the host
+    device.waitFor(dataTag);
+
+    /*MPI exchange of host buffer*/
+    exchange->Start (haloBuf, K, Add, NoTrans);
+    exchange->Finish(haloBuf, K, Add, NoTrans);
+
+    // copy recv back to device, ordered before later work on the current stream
+    haloBuf.copyTo(o_haloBuf+K*NhaloP, K*Nhalo,
+                   K*NhaloP, "async: true");
+  }
+
+  //unpack each field and write it back to its vector
+  int offset=0;
+  for (auto& f : fields) {
+    if (gathered_halo) {
+      if (Nhalo) {
+        ogsExchange_t::unpackFieldsKernel(Nhalo, K, offset, f.k,
+                                          o_haloBuf + K*NhaloP,
+                                          f.o_v + f.k*(NlocalT+NhaloP));
+      }
+    } else {
+      if (NhaloP+Nhalo) {
+        ogsExchange_t::unpackFieldsKernel(NhaloP+Nhalo, K, offset, f.k,
+                                          o_haloBuf, o_fieldBuf);
+      }
+      gatherHalo->Scatter(f.o_v, o_fieldBuf, f.k, NoTrans);
+    }
+    offset += f.k;
+  }
+}
+
+/********************************
+ * Reduced precision Exchange
+ ********************************/
+void halo_t::SetReducedPrecision(const bool reduced) {
+  reduced_precision = reduced;
+
+  if (reduced_precision) {
+    //the exchange runs in single precision, with conversion kernels on either side
+    InitializeKernels(platform, Double, Add);
+    InitializeKernels(platform, Float, Add);
+  }
+}
+
+void halo_t::ReducedExchangeStart(deviceMemory<double> o_v, const int k){
+  exchange->AllocBuffer(k*sizeof(double));
+
+  deviceMemory<float> o_haloBuf = exchange->o_workspace;
+
+  //find the double precision halo values to send
+  deviceMemory<double> o_src;
+  if (gathered_halo) {
+    //if this halo was build from a gathered ogs the halo nodes are at the end
+    o_src = o_v + k*NlocalT;
+  } else {
+    if (o_haloDbl.length() < static_cast<size_t>(k*NhaloT)) {
+      o_haloDbl = platform.malloc<double>(k*NhaloT);
+    }
+
+    //collect halo buffer
+    gatherHalo->Gather(o_haloDbl, o_v, k, Add, NoTrans);
+    o_src = o_haloDbl;
+  }
+
+  //down-convert to the send buffer
+  if (NhaloP) {
+    ogsExchange_t::downConvertKernel(k*NhaloP, o_src, o_haloBuf);
+  }
+
+  if (exchange->gpu_aware) {
+    //prepare MPI exchange
+    exchange->Start(o_haloBuf, k, Add, NoTrans);
+
+  } else if (exchange->staged) {
+    //stage the exchange through the host peer by peer
+    exchange->StagedStart(o_haloBuf, k, Add, NoTrans);
+
+  } else {
+    //get current stream
+    device_t &device = platform.device;
+    stream_t currentStream = device.getStream();
+
+    //if not using gpu-aware mpi move the halo buffer to the host
+    pinnedMemory<float> haloBuf = exchange->h_workspace;
+
+    //wait for the work producing o_haloBuf
+    device.waitFor(device.tagStream());
+
+    //queue copy to host, and tag its completion
+    device.setStream(dataStream);
+    haloBuf.copyFrom(o_haloBuf, NhaloP*k,
+                     0, "async: true");
+    dataTag = device.tagStream();
+    device.setStream(currentStream);
+  }
+}
+
+void halo_t::ReducedExchangeFinish(deviceMemory<double> o_v, const int k){
+
+  deviceMemory<float> o_haloBuf = exchange->o_workspace;
+
+  if (exchange->gpu_aware) {
+    //finish MPI exchange
+    exchange->Finish(o_haloBuf, k, Add, NoTrans);
+  } else if (exchange->staged) {
+    //copy received chunks back as they arrive
+    exchange->StagedFinish(o_haloBuf, k, Add, NoTrans);
+  } else {
+    pinnedMemory<float> haloBuf = exchange->h_workspace;
+
+    device_t &device = platform.device;
+
+    //wait for the copy of the halo buffer to the host
+    device.waitFor(dataTag);
+
+    /*MPI exchange of host buffer*/
+    exchange->Start (haloBuf, k, Add, NoTrans);
+    exchange->Finish(haloBuf, k, Add, NoTrans);
+
+    // copy recv back to device, ordered before later work on the current stream
+    haloBuf.copyTo(o_haloBuf+k*NhaloP, k*Nhalo,
+                   k*NhaloP, "async: true");
+  }
+
+  //up-convert the received halo values and write them back to vector
+  if (gathered_halo) {
+    if (Nhalo) {
+      ogsExchange_t::upConvertKernel(k*Nhalo, o_haloBuf + k*NhaloP,
+                                     o_v + k*(NlocalT+NhaloP));
+    }
+  } else {
+    if (Nhalo) {
+      ogsExchange_t::upConvertKernel(k*Nhalo, o_haloBuf + k*NhaloP,
+                                     o_haloDbl + k*NhaloP);
+    }
+    gatherHalo->Scatter(o_v, o_haloDbl, k, NoTrans);
+  }
+}
+
+void halo_t::ReducedExchangeStart(memory<double> v, const int k) {
+  exchange->AllocBuffer(k*sizeof(double));
+
+  pinnedMemory<float> haloBuf = exchange->h_workspace;
+
+  //find the double precision halo values to send
+  memory<double> src;
+  if (gathered_halo) {
+    //if this halo was build from a gathered ogs the halo nodes are at the end
+    src = v + k*NlocalT;
+  } else {
+    if (haloDbl.length() < static_cast<size_t>(k*NhaloT)) {
+      haloDbl.malloc(k*NhaloT);
+    }
+
+    //collect halo buffer
+    gatherHalo->Gather(haloDbl, v, k, Add, NoTrans);
+    src = haloDbl;
+  }
+
+  //down-convert to the send buffer
+  for (dlong n=0;n<k*NhaloP;++n) {
+    haloBuf[n] = static_cast<float>(src[n]);
+  }
+
+  //Prepare MPI exchange
+  exchange->Start(haloBuf, k, Add, NoTrans);
+}
+
+void halo_t::ReducedExchangeFinish(memory<double> v, const int k) {
+
+  pinnedMemory<float> haloBuf = exchange->h_workspace;
+
+  //finish MPI exchange
+  exchange->Finish(haloBuf, k, Add, NoTrans);
+
+  //up-convert the received halo values and write them back to vector
+  if (gathered_halo) {
+    memory<double> dst = v + k*(NlocalT+NhaloP);
+    for (dlong n=0;n<k*Nhalo;++n) {
+      dst[n] = static_cast<double>(haloBuf[k*NhaloP+n]);
+    }
+  } else {
+    for (dlong n=0;n<k*Nhalo;++n) {
+      haloDbl[k*NhaloP+n] = static_cast<double>(haloBuf[k*NhaloP+n]);
+    }
+    gatherHalo->Scatter(v, haloDbl, k, NoTrans);
+  }
+}
+
 /********************************
  * Combine
  ********************************/
@@ -207,11 +543,13 @@ void halo_t::Combine(deviceMemory<T> o_v, const int k) {
 
 template<typename T>
 void halo_t::CombineStart(deviceMemory<T> o_v, const int k){
+  exchangeTimer_t timer = SelectExchange(k, Trans);
+
   exchange->AllocBuffer(k*sizeof(T));
 
   deviceMemory<T> o_haloBuf = exchange->o_workspace;
 
-  if (exchange->gpu_aware) {
+  if (exchange->gpu_aware || exchange->staged) {
     if (gathered_halo) {
       //if this halo was build from a gathered ogs the halo nodes are at the end
       o_haloBuf.copyFrom(o_v + k*NlocalT, k*NhaloT,
@@ -221,8 +559,13 @@ void halo_t::CombineStart(deviceMemory<T> o_v, const int k){
       gatherHalo->Gather(o_haloBuf, o_v, k, Add, Trans);
     }
 
-    //prepare MPI exchange
-    exchange->Start(o_haloBuf, k, Add, Trans);
+    if (exchange->gpu_aware) {
+      //prepare MPI exchange
+      exchange->Start(o_haloBuf, k, Add, Trans);
+    } else {
+      //stage the exchange through the host peer by peer
+      exchange->StagedStart(o_haloBuf, k, Add, Trans);
+    }
   } else {
     //get current stream
     device_t &device = platform.device;
@@ -232,25 +575,27 @@ void halo_t::CombineStart(deviceMemory<T> o_v, const int k){
     pinnedMemory<T> haloBuf = exchange->h_workspace;
 
     if (gathered_halo) {
-      //wait for o_v to be ready
-      device.finish();
+      //wait for the work producing o_v
+      device.waitFor(device.tagStream());
 
-      //queue copy to host
+      //queue copy to host, and tag its completion
       device.setStream(dataStream);
       haloBuf.copyFrom(o_v + k*NlocalT, NhaloT*k,
                        0, "async: true");
+      dataTag = device.tagStream();
       device.setStream(currentStream);
     } else {
       //collect halo buffer
       gatherHalo->Gather(o_haloBuf, o_v, k, Add, Trans);
 
-      //wait for o_haloBuf to be ready
-      device.finish();
+      //wait for the work producing o_haloBuf
+      device.waitFor(device.tagStream());
 
-      //queue copy to host
+      //queue copy to host, and tag its completion
       device.setStream(dataStream);
       haloBuf.copyFrom(o_haloBuf, NhaloT*k,
                        0, "async: true");
+      dataTag = device.tagStream();
       device.setStream(currentStream);
     }
   }
@@ -258,13 +603,19 @@ void halo_t::CombineStart(deviceMemory<T> o_v, const int k){
 
 template<typename T>
 void halo_t::CombineFinish(deviceMemory<T> o_v, const int k){
+  exchangeTimer_t timer = SelectExchange(k, Trans, /*finish=*/true);
 
   deviceMemory<T> o_haloBuf = exchange->o_workspace;
 
   //write exchanged halo buffer back to vector
-  if (exchange->gpu_aware) {
-    //finish MPI exchange
-    exchange->Finish(o_haloBuf, k, Add, Trans);
+  if (exchange->gpu_aware || exchange->staged) {
+    if (exchange->gpu_aware) {
+      //finish MPI exchange
+      exchange->Finish(o_haloBuf, k, Add, Trans);
+    } else {
+      //copy received chunks back as they arrive
+      exchange->StagedFinish(o_haloBuf, k, Add, Trans);
+    }
 
     if (gathered_halo) {
       //if this halo was build from a gathered ogs the halo nodes are at the end
@@ -276,39 +627,42 @@ void halo_t::CombineFinish(deviceMemory<T> o_v, const int k){
   } else {
     pinnedMemory<T> haloBuf = exchange->h_workspace;
 
-    //get current stream
     device_t &device = platform.device;
-    stream_t currentStream = device.getStream();
 
-    //synchronize data stream to ensure the buffer is on the host
-    device.setStream(dataStream);
-    device.finish();
+    //wait for the copy of the halo buffer to the host
+    device.waitFor(dataTag);
 
     /*MPI exchange of host buffer*/
     exchange->Start (haloBuf, k, Add, Trans);
     exchange->Finish(haloBuf, k, Add, Trans);
 
     if (gathered_halo) {
-      // copy recv back to device
+      // copy recv back to device, ordered before later work on the current stream
       haloBuf.copyTo(o_v + k*NlocalT, NhaloP*k,
                      0, "async: true");
-      device.finish(); //wait for transfer to finish
-      device.setStream(currentStream);
     } else {
       haloBuf.copyTo(o_haloBuf, NhaloP*k,
                      0, "async: true");
-      device.finish(); //wait for transfer to finish
-      device.setStream(currentStream);
 
       gatherHalo->Scatter(o_v, o_haloBuf, k, Trans);
     }
   }
 }
 
+template<typename T>
+ogsFuture_t halo_t::CombineAsync(deviceMemory<T> o_v, const int k){
+  return Launch([=]() { CombineStart (o_v, k); },
+                [=]() { CombineFinish(o_v, k); });
+}
+
 template void halo_t::Combine(deviceMemory<float> o_v, const int k);
 template void halo_t::Combine(deviceMemory<double> o_v, const int k);
 template void halo_t::Combine(deviceMemory<int> o_v, const int k);
 template void halo_t::Combine(deviceMemory<long long int> o_v, const int k);
+template ogsFuture_t halo_t::CombineAsync(deviceMemory<float> o_v, const int k);
+template ogsFuture_t halo_t::CombineAsync(deviceMemory<double> o_v, const int k);
+template ogsFuture_t halo_t::CombineAsync(deviceMemory<int> o_v, const int k);
+template ogsFuture_t halo_t::CombineAsync(deviceMemory<long long int> o_v, const int k);
 
 //host version
 template<typename T>
@@ -319,6 +673,8 @@ void halo_t::Combine(memory<T> v, const int k) {
 
 template<typename T>
 void halo_t::CombineStart(memory<T> v, const int k) {
+  exchangeTimer_t timer = SelectExchange(k, Trans);
+
   exchange->AllocBuffer(k*sizeof(T));
 
   pinnedMemory<T> haloBuf = exchange->h_workspace;
@@ -338,6 +694,7 @@ void halo_t::CombineStart(memory<T> v, const int k) {
 
 template<typename T>
 void halo_t::CombineFinish(memory<T> v, const int k) {
+  exchangeTimer_t timer = SelectExchange(k, Trans, /*finish=*/true);
 
   pinnedMemory<T> haloBuf = exchange->h_workspace;
 
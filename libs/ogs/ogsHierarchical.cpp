@@ -0,0 +1,278 @@
+/*
+
+The MIT License (MIT)
+
+Copyright (c) 2017-2022 Tim Warburton, Noel Chalmers, Jesse Chan, Ali Karakus
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+*/
+
+#include "ogs.hpp"
+#include "ogs/ogsUtils.hpp"
+#include "ogs/ogsExchange.hpp"
+
+#ifdef GLIBCXX_PARALLEL
+#include <parallel/algorithm>
+using __gnu_parallel::sort;
+#else
+using std::sort;
+#endif
+
+namespace libp {
+
+namespace ogs {
+
+/**********************************
+* Host exchange
+***********************************/
+template<typename T>
+inline void ogsHierarchical_t::Start(pinnedMemory<T> &buf, const int k,
+                                     const Op op, const Transpose trans){
+
+  pinnedMemory<T> nodeBuf = h_nodespace;
+
+  for (int r=0;r<nodeSize;r++) {
+    nodeCountsK[r]  = nodeCounts[r]*k;
+    nodeOffsetsK[r] = nodeOffsets[r]*k;
+  }
+
+  //start collecting the halo rows of every rank on this node at the leader
+  nodeComm.Igatherv(buf, Nhalo*k, nodeBuf, nodeCountsK, nodeOffsetsK, 0, nodeRequest);
+  if (nodeRank>0) RecordSend(nodeRanks[0], Nhalo*k*sizeof(T));
+}
+
+template<typename T>
+inline void ogsHierarchical_t::Finish(pinnedMemory<T> &buf, const int k,
+                                      const Op op, const Transpose trans){
+
+  pinnedMemory<T> nodeBuf = h_nodespace;
+
+  timePoint_t wait = Time();
+  nodeComm.Wait(nodeRequest);
+  RecordWait(wait);
+
+  if (nodeRank==0) {
+    memory<T> nodeRows = nodeRowspace;
+
+    //reduce rows with matching ids before they leave the node
+    nodeGather.Gather(nodeRows, nodeBuf, k, op, trans);
+
+    //one message per remote node
+    leaderOgs.GatherScatter(nodeRows, k, op,
+                            (trans==NoTrans) ? NoTrans : Sym);
+
+    //every contributing row receives the result
+    nodeGather.Scatter(nodeBuf, nodeRows, k, Sym);
+  }
+
+  //return the results to each rank on the node
+  wait = Time();
+  nodeComm.Scatterv(nodeBuf, nodeCountsK, nodeOffsetsK, buf, Nhalo*k, 0);
+  RecordWait(wait);
+  if (nodeRank==0) {
+    for (int r=1;r<nodeSize;r++)
+      RecordSend(nodeRanks[r], nodeCounts[r]*k*sizeof(T));
+  }
+}
+
+void ogsHierarchical_t::Start(pinnedMemory<float> &buf, const int k, const Op op, const Transpose trans) { Start<float>(buf, k, op, trans); }
+void ogsHierarchical_t::Start(pinnedMemory<double> &buf, const int k, const Op op, const Transpose trans) { Start<double>(buf, k, op, trans); }
+void ogsHierarchical_t::Start(pinnedMemory<int> &buf, const int k, const Op op, const Transpose trans) { Start<int>(buf, k, op, trans); }
+void ogsHierarchical_t::Start(pinnedMemory<long long int> &buf, const int k, const Op op, const Transpose trans) { Start<long long int>(buf, k, op, trans); }
+void ogsHierarchical_t::Finish(pinnedMemory<float> &buf, const int k, const Op op, const Transpose trans) { Finish<float>(buf, k, op, trans); }
+void ogsHierarchical_t::Finish(pinnedMemory<double> &buf, const int k, const Op op, const Transpose trans) { Finish<double>(buf, k, op, trans); }
+void ogsHierarchical_t::Finish(pinnedMemory<int> &buf, const int k, const Op op, const Transpose trans) { Finish<int>(buf, k, op, trans); }
+void ogsHierarchical_t::Finish(pinnedMemory<long long int> &buf, const int k, const Op op, const Transpose trans) { Finish<long long int>(buf, k, op, trans); }
+
+/**********************************
+* Device exchange
+***********************************/
+template<typename T>
+void ogsHierarchical_t::Start(deviceMemory<T> &o_buf,
+                              const int k,
+                              const Op op,
+                              const Transpose trans){
+
+  //the node-level reductions are done on the host, so stage through it
+  pinnedMemory<T> buf = h_workspace;
+
+  device_t &device = platform.device;
+  device.finish();
+
+  buf.copyFrom(o_buf, Nhalo*k);
+
+  Start(buf, k, op, trans);
+}
+
+template<typename T>
+void ogsHierarchical_t::Finish(deviceMemory<T> &o_buf,
+                               const int k,
+                               const Op op,
+                               const Transpose trans){
+
+  pinnedMemory<T> buf = h_workspace;
+
+  Finish(buf, k, op, trans);
+
+  o_buf.copyFrom(buf, Nhalo*k);
+}
+
+void ogsHierarchical_t::Start(deviceMemory<float> &buf, const int k, const Op op, const Transpose trans) { Start<float>(buf, k, op, trans); }
+void ogsHierarchical_t::Start(deviceMemory<double> &buf, const int k, const Op op, const Transpose trans) { Start<double>(buf, k, op, trans); }
+void ogsHierarchical_t::Start(deviceMemory<int> &buf, const int k, const Op op, const Transpose trans) { Start<int>(buf, k, op, trans); }
+void ogsHierarchical_t::Start(deviceMemory<long long int> &buf, const int k, const Op op, const Transpose trans) { Start<long long int>(buf, k, op, trans); }
+void ogsHierarchical_t::Finish(deviceMemory<float> &buf, const int k, const Op op, const Transpose trans) { Finish<float>(buf, k, op, trans); }
+void ogsHierarchical_t::Finish(deviceMemory<double> &buf, const int k, const Op op, const Transpose trans) { Finish<double>(buf, k, op, trans); }
+void ogsHierarchical_t::Finish(deviceMemory<int> &buf, const int k, const Op op, const Transpose trans) { Finish<int>(buf, k, op, trans); }
+void ogsHierarchical_t::Finish(deviceMemory<long long int> &buf, const int k, const Op op, const Transpose trans) { Finish<long long int>(buf, k, op, trans); }
+
+ogsHierarchical_t::ogsHierarchical_t(dlong Nshared,
+                                     memory<parallelNode_t> &sharedNodes,
+                                     ogsOperator_t& gatherHalo,
+                                     stream_t _dataStream,
+                                     comm_t _comm,
+                                     platform_t &_platform):
+  ogsExchange_t(_platform,_comm,_dataStream) {
+
+  Nhalo  = gatherHalo.NrowsT;
+  NhaloP = gatherHalo.NrowsN;
+
+  nodeComm = comm.SplitShared(rank);
+  nodeRank = nodeComm.rank();
+  nodeSize = nodeComm.size();
+
+  //the leaders of each node do the inter-node exchange
+  leaderComm = comm.Split((nodeRank==0) ? 0 : 1, rank);
+
+  //label each halo row with its global id, flagging
+  // the rows which are not positive on this rank
+  memory<hlong> rowIds(Nhalo, 0);
+  for (dlong n=0;n<Nshared;n++) {
+    const dlong id = sharedNodes[n].newId;
+    const hlong baseId = std::abs(sharedNodes[n].baseId);
+    rowIds[id] = (id<NhaloP) ? baseId : -baseId;
+  }
+
+  //collect the row ids on the leader
+  nodeCounts.malloc(nodeSize);
+  nodeOffsets.malloc(nodeSize+1);
+  nodeCountsK.malloc(nodeSize);
+  nodeOffsetsK.malloc(nodeSize);
+
+  nodeComm.Allgather(Nhalo, nodeCounts);
+
+  //rank of each node rank in comm, for the exchange statistics
+  nodeRanks.malloc(nodeSize);
+  nodeComm.Allgather(rank, nodeRanks);
+  nodeOffsets[0] = 0;
+  for (int r=0;r<nodeSize;r++)
+    nodeOffsets[r+1] = nodeOffsets[r] + nodeCounts[r];
+
+  NnodeCols = (nodeRank==0) ? nodeOffsets[nodeSize] : 0;
+  memory<hlong> nodeIds(NnodeCols);
+
+  nodeComm.Gatherv(rowIds, Nhalo, nodeIds, nodeCounts, nodeOffsets, 0);
+
+  nodeGather.platform = platform;
+  nodeGather.kind = Signed;
+
+  if (nodeRank==0) {
+    //group the gathered rows by id
+    memory<dlong> perm(NnodeCols);
+    for (dlong n=0;n<NnodeCols;n++) perm[n] = n;
+
+    sort(perm.ptr(), perm.ptr()+NnodeCols,
+         [&](const dlong& a, const dlong& b) {
+           const hlong ida = std::abs(nodeIds[a]);
+           const hlong idb = std::abs(nodeIds[b]);
+           if (ida < idb) return true;
+           if (ida > idb) return false;
+           return a < b;
+         });
+
+    NnodeRows=0;
+    for (dlong n=0;n<NnodeCols;n++) {
+      if (n==0 || std::abs(nodeIds[perm[n]])!=std::abs(nodeIds[perm[n-1]]))
+        NnodeRows++;
+    }
+
+    nodeGather.NrowsN = NnodeRows;
+    nodeGather.NrowsT = NnodeRows;
+    nodeGather.Ncols  = NnodeCols;
+    nodeGather.rowStartsN.calloc(NnodeRows+1);
+    nodeGather.rowStartsT.calloc(NnodeRows+1);
+
+    //a node row is flagged unless some rank has a positive copy
+    memory<hlong> nodeRowIds(NnodeRows, 0);
+
+    dlong row=-1;
+    for (dlong n=0;n<NnodeCols;n++) {
+      const hlong id = nodeIds[perm[n]];
+      if (n==0 || std::abs(id)!=std::abs(nodeIds[perm[n-1]])) {
+        row++;
+        nodeRowIds[row] = -std::abs(id);
+      }
+      if (id>0) {
+        nodeRowIds[row] = id;
+        nodeGather.rowStartsN[row+1]++;
+      }
+      nodeGather.rowStartsT[row+1]++;
+    }
+
+    for (dlong r=0;r<NnodeRows;r++) {
+      nodeGather.rowStartsN[r+1] += nodeGather.rowStartsN[r];
+      nodeGather.rowStartsT[r+1] += nodeGather.rowStartsT[r];
+    }
+    nodeGather.nnzN = nodeGather.rowStartsN[NnodeRows];
+    nodeGather.nnzT = nodeGather.rowStartsT[NnodeRows];
+    nodeGather.colIdsN.malloc(nodeGather.nnzN);
+    nodeGather.colIdsT.malloc(nodeGather.nnzT);
+
+    dlong cntN=0, cntT=0;
+    for (dlong n=0;n<NnodeCols;n++) {
+      if (nodeIds[perm[n]]>0) nodeGather.colIdsN[cntN++] = perm[n];
+      nodeGather.colIdsT[cntT++] = perm[n];
+    }
+
+    //exchange between node leaders, one message per remote node
+    leaderOgs.Setup(NnodeRows, nodeRowIds, leaderComm,
+                    Signed, Pairwise, false, false, platform);
+  }
+
+  //make scratch space
+  AllocBuffer(sizeof(dfloat));
+}
+
+void ogsHierarchical_t::AllocBuffer(size_t Nbytes) {
+  if (h_workspace.size() < Nhalo*Nbytes) {
+    h_workspace = platform.hostMalloc<char>(Nhalo*Nbytes);
+    o_workspace = platform.malloc<char>(Nhalo*Nbytes);
+  }
+  if (h_nodespace.size() < NnodeCols*Nbytes) {
+    h_nodespace = platform.hostMalloc<char>(NnodeCols*Nbytes);
+  }
+  if (nodeRowspace.size() < NnodeRows*Nbytes) {
+    nodeRowspace.malloc(NnodeRows*Nbytes);
+  }
+}
+
+} //namespace ogs
+
+} //namespace libp
@@ -0,0 +1,298 @@
+/*
+
+The MIT License (MIT)
+
+Copyright (c) 2017-2022 Tim Warburton, Noel Chalmers, Jesse Chan, Ali Karakus
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+*/
+#include "ogs.hpp"
+#include "ogs/ogsUtils.hpp"
+#include "ogs/ogsExchange.hpp"
+
+namespace libp {
+
+namespace ogs {
+
+/**********************************
+* Host exchange
+***********************************/
+template<typename T>
+inline void ogsHybrid_t::Start(pinnedMemory<T> &buf, const int k,
+                               const Op op, const Transpose trans){
+
+  //route the small messages from a copy of the halo rows they touch,
+  // so both exchanges start from the same values
+  if (router) {
+    pinnedMemory<T> lightBuf = router->h_workspace;
+    extract(NlightHalo, k, lightIds, buf, lightBuf);
+
+    router->tagOffset = tagOffset;
+    router->Start(lightBuf, k, op, trans);
+  }
+
+  ogsPairwise_t::Start(buf, k, op, trans);
+}
+
+template<typename T>
+inline void ogsHybrid_t::Finish(pinnedMemory<T> &buf, const int k,
+                                const Op op, const Transpose trans){
+
+  const int NranksSend  = (trans==NoTrans) ? NranksSendN  : NranksSendT;
+  const int NranksRecv  = (trans==NoTrans) ? NranksRecvN  : NranksRecvT;
+  const int *recvOffsets= (trans==NoTrans) ? recvOffsetsN.ptr() : recvOffsetsT.ptr();
+
+  pinnedMemory<T> lightBuf;
+  if (router) router->Finish(lightBuf, k, op, trans);
+
+  timePoint_t wait = Time();
+  comm.Waitall(NranksRecv+NranksSend, requests);
+  RecordWait(wait);
+  posted = false;
+  completed = false;
+
+  //write the routed rows back, then gather the pairwise messages into them
+  if (router) {
+    #pragma omp parallel for
+    for (dlong n=0;n<NlightHalo;n++) {
+      const dlong id = lightIds[n];
+      for (int j=0;j<k;j++) buf[id*k+j] = lightBuf[n*k+j];
+    }
+  }
+
+  dlong Nrecv = recvOffsets[NranksRecv];
+  if (Nrecv || router) {
+    postmpi.Gather(buf, buf, k, op, trans);
+  }
+}
+
+void ogsHybrid_t::Start(pinnedMemory<float> &buf, const int k, const Op op, const Transpose trans) { Start<float>(buf, k, op, trans); }
+void ogsHybrid_t::Start(pinnedMemory<double> &buf, const int k, const Op op, const Transpose trans) { Start<double>(buf, k, op, trans); }
+void ogsHybrid_t::Start(pinnedMemory<int> &buf, const int k, const Op op, const Transpose trans) { Start<int>(buf, k, op, trans); }
+void ogsHybrid_t::Start(pinnedMemory<long long int> &buf, const int k, const Op op, const Transpose trans) { Start<long long int>(buf, k, op, trans); }
+void ogsHybrid_t::Finish(pinnedMemory<float> &buf, const int k, const Op op, const Transpose trans) { Finish<float>(buf, k, op, trans); }
+void ogsHybrid_t::Finish(pinnedMemory<double> &buf, const int k, const Op op, const Transpose trans) { Finish<double>(buf, k, op, trans); }
+void ogsHybrid_t::Finish(pinnedMemory<int> &buf, const int k, const Op op, const Transpose trans) { Finish<int>(buf, k, op, trans); }
+void ogsHybrid_t::Finish(pinnedMemory<long long int> &buf, const int k, const Op op, const Transpose trans) { Finish<long long int>(buf, k, op, trans); }
+
+/**********************************
+* Device exchange
+***********************************/
+template<typename T>
+void ogsHybrid_t::Start(deviceMemory<T> &o_buf,
+                        const int k,
+                        const Op op,
+                        const Transpose trans){
+
+  //the routed rows are combined with the pairwise messages on the host,
+  // so stage through it
+  pinnedMemory<T> buf = h_workspace;
+
+  device_t &device = platform.device;
+  stream_t currentStream = device.getStream();
+
+  //wait for the work producing o_buf. This also retires the copy back to
+  // the device from the previous exchange, so the host buffer is free
+  device.waitFor(device.tagStream());
+
+  //copy to the host on this exchange's stream, and wait only on that copy
+  device.setStream(dataStream);
+  buf.copyFrom(o_buf, Nhalo*k, 0, "async: true");
+  streamTag_t copyTag = device.tagStream();
+  device.setStream(currentStream);
+
+  device.waitFor(copyTag);
+
+  Start(buf, k, op, trans);
+}
+
+template<typename T>
+void ogsHybrid_t::Finish(deviceMemory<T> &o_buf,
+                         const int k,
+                         const Op op,
+                         const Transpose trans){
+
+  pinnedMemory<T> buf = h_workspace;
+
+  Finish(buf, k, op, trans);
+
+  //copy back, ordered before later work on the current stream
+  buf.copyTo(o_buf, Nhalo*k, 0, "async: true");
+}
+
+void ogsHybrid_t::Start(deviceMemory<float> &buf, const int k, const Op op, const Transpose trans) { Start<float>(buf, k, op, trans); }
+void ogsHybrid_t::Start(deviceMemory<double> &buf, const int k, const Op op, const Transpose trans) { Start<double>(buf, k, op, trans); }
+void ogsHybrid_t::Start(deviceMemory<int> &buf, const int k, const Op op, const Transpose trans) { Start<int>(buf, k, op, trans); }
+void ogsHybrid_t::Start(deviceMemory<long long int> &buf, const int k, const Op op, const Transpose trans) { Start<long long int>(buf, k, op, trans); }
+void ogsHybrid_t::Finish(deviceMemory<float> &buf, const int k, const Op op, const Transpose trans) { Finish<float>(buf, k, op, trans); }
+void ogsHybrid_t::Finish(deviceMemory<double> &buf, const int k, const Op op, const Transpose trans) { Finish<double>(buf, k, op, trans); }
+void ogsHybrid_t::Finish(deviceMemory<int> &buf, const int k, const Op op, const Transpose trans) { Finish<int>(buf, k, op, trans); }
+void ogsHybrid_t::Finish(deviceMemory<long long int> &buf, const int k, const Op op, const Transpose trans) { Finish<long long int>(buf, k, op, trans); }
+
+void ogsHybrid_t::Progress() {
+  if (router) router->Progress();
+}
+
+bool ogsHybrid_t::Ready() {
+  if (router && !router->Ready()) return false;
+  return ogsPairwise_t::Ready();
+}
+
+/*
+ * Move the shared nodes of peers sharing at least threshold nodes with
+ * this rank to the front of the list, keeping their order, and return
+ * their count. Every shared node appears in the lists of both ranks of a
+ * pair, so both ranks agree on the side of the threshold a pair falls.
+ */
+dlong ogsHybrid_t::PartitionPeers(dlong Nshared,
+                                  memory<parallelNode_t> &sharedNodes,
+                                  const dlong threshold,
+                                  comm_t comm) {
+  const int size = comm.size();
+
+  memory<dlong> peerCounts(size, 0);
+  for (dlong n=0;n<Nshared;n++) peerCounts[sharedNodes[n].rank]++;
+
+  memory<parallelNode_t> lightNodes(Nshared);
+
+  dlong Nheavy=0, Nlight=0;
+  for (dlong n=0;n<Nshared;n++) {
+    if (peerCounts[sharedNodes[n].rank] >= threshold)
+      sharedNodes[Nheavy++] = sharedNodes[n];
+    else
+      lightNodes[Nlight++] = sharedNodes[n];
+  }
+  for (dlong n=0;n<Nlight;n++) sharedNodes[Nheavy+n] = lightNodes[n];
+
+  return Nheavy;
+}
+
+ogsHybrid_t::ogsHybrid_t(dlong Nshared,
+                         memory<parallelNode_t> &sharedNodes,
+                         ogsOperator_t& gatherHalo,
+                         stream_t _dataStream,
+                         comm_t _comm,
+                         platform_t &_platform,
+                         const dlong _threshold):
+  ogsPairwise_t(PartitionPeers(Nshared, sharedNodes, _threshold, _comm),
+                sharedNodes, gatherHalo, _dataStream, _comm, _platform),
+  threshold(_threshold) {
+
+  //the pairwise exchange was built from the leading nodes of large peers,
+  // and sends each of them once
+  const dlong Nheavy = NsendT;
+  const dlong Nlight = Nshared - Nheavy;
+  memory<parallelNode_t> lightNodes = sharedNodes + Nheavy;
+
+  hlong NlightGlobal = Nlight;
+  comm.Allreduce(NlightGlobal);
+
+  //the combined halo buffer is reduced on the host
+  staged = false;
+
+  if (NlightGlobal==0) return;
+
+  //compress the halo rows shared with small peers, positive rows first
+  memory<int> isLight(Nhalo, 0);
+  for (dlong n=0;n<Nlight;n++) isLight[lightNodes[n].newId] = 1;
+
+  memory<dlong> lightMap(Nhalo, -1);
+  NlightHalo=0;
+  for (dlong n=0;n<NhaloP;n++)
+    if (isLight[n]) lightMap[n] = NlightHalo++;
+  const dlong NlightP = NlightHalo;
+  for (dlong n=NhaloP;n<Nhalo;n++)
+    if (isLight[n]) lightMap[n] = NlightHalo++;
+
+  lightIds.malloc(NlightHalo);
+  for (dlong n=0;n<Nhalo;n++)
+    if (lightMap[n]>=0) lightIds[lightMap[n]] = n;
+
+  memory<parallelNode_t> routedNodes(Nlight);
+  for (dlong n=0;n<Nlight;n++) {
+    routedNodes[n] = lightNodes[n];
+    routedNodes[n].newId = lightMap[lightNodes[n].newId];
+  }
+
+  //the router only reads the halo sizes of its gather operator
+  ogsOperator_t lightHalo(platform);
+  lightHalo.NrowsN = NlightP;
+  lightHalo.NrowsT = NlightHalo;
+
+  //messages of the router and the pairwise exchange may be in flight
+  // between the same ranks at once, so keep them on separate communicators
+  router = std::make_shared<ogsCrystalRouter_t>(Nlight, routedNodes, lightHalo,
+                                                dataStream, comm.Dup(), platform);
+
+  //The routed rows are written back into the halo buffer before the pairwise
+  // messages are gathered, so flagged rows reached by the router must keep
+  // their value in the NoTrans gather too
+  memory<dlong> rowStartsN(Nhalo+1);
+  rowStartsN[0] = 0;
+  for (dlong n=0;n<Nhalo;n++) {
+    const dlong self = (n>=NhaloP && isLight[n]) ? 1 : 0;
+    rowStartsN[n+1] = rowStartsN[n] + self
+                    + postmpi.rowStartsN[n+1] - postmpi.rowStartsN[n];
+  }
+
+  memory<dlong> colIdsN(rowStartsN[Nhalo]);
+  for (dlong n=0;n<Nhalo;n++) {
+    dlong cnt = rowStartsN[n];
+    if (n>=NhaloP && isLight[n]) colIdsN[cnt++] = n;
+    for (dlong j=postmpi.rowStartsN[n];j<postmpi.rowStartsN[n+1];j++)
+      colIdsN[cnt++] = postmpi.colIdsN[j];
+  }
+
+  postmpi.rowStartsN = rowStartsN;
+  postmpi.colIdsN = colIdsN;
+  postmpi.nnzN = rowStartsN[Nhalo];
+  postmpi.o_rowStartsN = platform.malloc(postmpi.rowStartsN);
+  postmpi.o_colIdsN = platform.malloc(postmpi.colIdsN);
+  postmpi.setupRowBlocks();
+
+  //make scratch space
+  AllocBuffer(sizeof(dfloat));
+}
+
+void ogsHybrid_t::AllocBuffer(size_t Nbytes) {
+  ogsPairwise_t::AllocBuffer(Nbytes);
+  if (router) router->AllocBuffer(Nbytes);
+}
+
+ogsExchange_t* ogsHybrid_t::Clone() {
+  ogsHybrid_t* clone = new ogsHybrid_t(*this);
+
+  //private buffers and requests, allocated on first use
+  clone->h_workspace = pinnedMemory<char>();
+  clone->o_workspace = deviceMemory<char>();
+  clone->h_sendspace = pinnedMemory<char>();
+  clone->o_sendspace = deviceMemory<char>();
+  clone->requests.malloc(NranksSendT+NranksRecvT);
+  clone->sendTags.malloc(NranksSendT);
+  if (router) {
+    clone->router = std::shared_ptr<ogsCrystalRouter_t>(
+                      static_cast<ogsCrystalRouter_t*>(router->Clone()));
+  }
+  return clone;
+}
+
+} //namespace ogs
+
+} //namespace libp
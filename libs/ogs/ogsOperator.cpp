@@ -25,6 +25,7 @@ SOFTWARE.
 */
 
 #include <limits>
+#include <algorithm>
 #include "ogs.hpp"
 #include "ogs/ogsUtils.hpp"
 #include "ogs/ogsOperator.hpp"
@@ -35,25 +36,199 @@ namespace ogs {
 
 template<typename T>
 struct Op_Add {
-  inline const T init(){ return T{0}; }
-  inline void operator()(T& gv, const T v) { gv += v; }
+  static inline T init(){ return T{0}; }
+  static inline void apply(T& gv, const T v) { gv += v; }
 };
 template<typename T>
 struct Op_Mul {
-  inline const T init(){ return T{1}; }
-  inline void operator()(T& gv, const T v) { gv *= v; }
+  static inline T init(){ return T{1}; }
+  static inline void apply(T& gv, const T v) { gv *= v; }
 };
 template<typename T>
 struct Op_Max {
-  inline const T init(){ return -std::numeric_limits<T>::max(); }
-  inline void operator()(T& gv, const T v) { gv = (v>gv) ? v : gv; }
+  static inline T init(){ return -std::numeric_limits<T>::max(); }
+  static inline void apply(T& gv, const T v) { gv = (v>gv) ? v : gv; }
 };
 template<typename T>
 struct Op_Min {
-  inline const T init() {return  std::numeric_limits<T>::max(); }
-  inline void operator()(T& gv, const T v) { gv = (v<gv) ? v : gv; }
+  static inline T init() {return  std::numeric_limits<T>::max(); }
+  static inline void apply(T& gv, const T v) { gv = (v<gv) ? v : gv; }
 };
 
+/********************************
+ * Host row kernels
+ ********************************/
+// Rows are split among threads with static schedules, matching the
+// partition used to first-touch the operator's arrays in setupRowBlocks.
+// The K entries of each node are processed in chunks of SIMD lanes. KC is
+// the number of entries when known at compile time (0 otherwise).
+static constexpr int kChunk = 8;
+
+//reduce entries [k0, k0+W) of the nodes in a row, where W is the chunk
+// width if known at compile time, and Kc otherwise. Rows of one or two
+// nodes, which are most rows of a conforming mesh, skip the general loop
+template<template<typename> class Op, typename T, int W>
+static inline void ReduceRow(const dlong* cols, const dlong Ncols,
+                             const int K, const int k0, const int Kc_,
+                             const T* v, T* val) {
+  const int Kc = (W>0) ? W : Kc_;
+
+  if (Ncols==1) {
+    const T* v0 = v + cols[0]*K + k0;
+    #pragma omp simd
+    for (int k=0;k<Kc;++k) val[k] = v0[k];
+  } else if (Ncols==2) {
+    const T* v0 = v + cols[0]*K + k0;
+    const T* v1 = v + cols[1]*K + k0;
+    #pragma omp simd
+    for (int k=0;k<Kc;++k) {
+      T r = v0[k];
+      Op<T>::apply(r, v1[k]);
+      val[k] = r;
+    }
+  } else {
+    #pragma omp simd
+    for (int k=0;k<Kc;++k) val[k] = Op<T>::init();
+
+    for (dlong g=0;g<Ncols;++g) {
+      const T* vg = v + cols[g]*K + k0;
+      #pragma omp simd
+      for (int k=0;k<Kc;++k) Op<T>::apply(val[k], vg[k]);
+    }
+  }
+}
+
+//gather chunks of kChunk entries at a time, then the remainder
+template<template<typename> class Op, typename T, int KC>
+static inline void GatherRow(const dlong* cols, const dlong Ncols,
+                             const int K_, const T* v, T* gvn) {
+  const int K = (KC>0) ? KC : K_;
+
+  int k0=0;
+  for (;k0+kChunk<=K;k0+=kChunk) {
+    T val[kChunk];
+    ReduceRow<Op, T, kChunk>(cols, Ncols, K, k0, kChunk, v, val);
+    #pragma omp simd
+    for (int k=0;k<kChunk;++k) gvn[k0+k] = val[k];
+  }
+  if (k0<K) {
+    constexpr int W = (KC>0) ? KC%kChunk : 0;
+    const int Kc = K-k0;
+    T val[kChunk];
+    ReduceRow<Op, T, W>(cols, Ncols, K, k0, Kc, v, val);
+    #pragma omp simd
+    for (int k=0;k<Kc;++k) gvn[k0+k] = val[k];
+  }
+}
+
+template<template<typename> class Op, typename T, int KC>
+static void GatherRowsK(const dlong Nrows,
+                       const dlong* rowStarts, const dlong* colIds,
+                       const int K_, const T* v, T* gv) {
+  const int K = (KC>0) ? KC : K_;
+
+  #pragma omp parallel for schedule(static)
+  for(dlong n=0;n<Nrows;++n){
+    const dlong start = rowStarts[n];
+    const dlong end   = rowStarts[n+1];
+    GatherRow<Op, T, KC>(colIds+start, end-start, K, v, gv + n*K);
+  }
+}
+
+template<typename T, int KC>
+static void ScatterRowsK(const dlong Nrows,
+                        const dlong* rowStarts, const dlong* colIds,
+                        const int K_, T* v, const T* gv) {
+  const int K = (KC>0) ? KC : K_;
+
+  #pragma omp parallel for schedule(static)
+  for(dlong n=0;n<Nrows;++n){
+    const dlong start = rowStarts[n];
+    const dlong end   = rowStarts[n+1];
+    const T* gvn = gv + n*K;
+
+    for(dlong g=start;g<end;++g){
+      T* vg = v + colIds[g]*K;
+      #pragma omp simd
+      for (int k=0;k<K;++k) vg[k] = gvn[k];
+    }
+  }
+}
+
+//reduce each row into a small buffer, then write it to the scatter nodes.
+// K is only as large as the number of fields, so the buffer is bounded
+template<template<typename> class Op, typename T, int KC>
+static void GatherScatterRowsK(const dlong Nrows,
+                              const dlong* gRowStarts, const dlong* gColIds,
+                              const dlong* sRowStarts, const dlong* sColIds,
+                              const int K_, T* v) {
+  const int K = (KC>0) ? KC : K_;
+
+  #pragma omp parallel for schedule(static)
+  for(dlong n=0;n<Nrows;++n){
+    const dlong gstart = gRowStarts[n];
+    const dlong gend   = gRowStarts[n+1];
+    const dlong sstart = sRowStarts[n];
+    const dlong send   = sRowStarts[n+1];
+
+    for (int k0=0;k0<K;k0+=kChunk) {
+      const int Kc = std::min(kChunk, K-k0);
+      T val[kChunk];
+      if (Kc==kChunk)
+        ReduceRow<Op, T, kChunk>(gColIds+gstart, gend-gstart, K, k0, Kc, v, val);
+      else
+        ReduceRow<Op, T, (KC>0) ? KC%kChunk : 0>(gColIds+gstart, gend-gstart, K, k0, Kc, v, val);
+
+      for(dlong s=sstart;s<send;++s){
+        T* vs = v + sColIds[s]*K + k0;
+        #pragma omp simd
+        for (int k=0;k<Kc;++k) vs[k] = val[k];
+      }
+    }
+  }
+}
+
+//use compile-time widths for the common small numbers of fields
+template<template<typename> class Op, typename T>
+static void GatherRows(const dlong Nrows,
+                       const dlong* rowStarts, const dlong* colIds,
+                       const int K, const T* v, T* gv) {
+  switch (K) {
+    case 1: GatherRowsK<Op, T, 1>(Nrows, rowStarts, colIds, K, v, gv); break;
+    case 2: GatherRowsK<Op, T, 2>(Nrows, rowStarts, colIds, K, v, gv); break;
+    case 3: GatherRowsK<Op, T, 3>(Nrows, rowStarts, colIds, K, v, gv); break;
+    case 4: GatherRowsK<Op, T, 4>(Nrows, rowStarts, colIds, K, v, gv); break;
+    default: GatherRowsK<Op, T, 0>(Nrows, rowStarts, colIds, K, v, gv);
+  }
+}
+
+template<typename T>
+static void ScatterRows(const dlong Nrows,
+                        const dlong* rowStarts, const dlong* colIds,
+                        const int K, T* v, const T* gv) {
+  switch (K) {
+    case 1: ScatterRowsK<T, 1>(Nrows, rowStarts, colIds, K, v, gv); break;
+    case 2: ScatterRowsK<T, 2>(Nrows, rowStarts, colIds, K, v, gv); break;
+    case 3: ScatterRowsK<T, 3>(Nrows, rowStarts, colIds, K, v, gv); break;
+    case 4: ScatterRowsK<T, 4>(Nrows, rowStarts, colIds, K, v, gv); break;
+    default: ScatterRowsK<T, 0>(Nrows, rowStarts, colIds, K, v, gv);
+  }
+}
+
+template<template<typename> class Op, typename T>
+static void GatherScatterRows(const dlong Nrows,
+                              const dlong* gRowStarts, const dlong* gColIds,
+                              const dlong* sRowStarts, const dlong* sColIds,
+                              const int K, T* v) {
+  switch (K) {
+    case 1: GatherScatterRowsK<Op, T, 1>(Nrows, gRowStarts, gColIds, sRowStarts, sColIds, K, v); break;
+    case 2: GatherScatterRowsK<Op, T, 2>(Nrows, gRowStarts, gColIds, sRowStarts, sColIds, K, v); break;
+    case 3: GatherScatterRowsK<Op, T, 3>(Nrows, gRowStarts, gColIds, sRowStarts, sColIds, K, v); break;
+    case 4: GatherScatterRowsK<Op, T, 4>(Nrows, gRowStarts, gColIds, sRowStarts, sColIds, K, v); break;
+    default: GatherScatterRowsK<Op, T, 0>(Nrows, gRowStarts, gColIds, sRowStarts, sColIds, K, v);
+  }
+}
+
 /********************************
  * Gather Operation
  ********************************/
@@ -81,19 +256,7 @@ void ogsOperator_t::Gather(U<T> gv,
   const T* v_ptr  = v.ptr();
   T* gv_ptr = gv.ptr();
 
-  #pragma omp parallel for
-  for(dlong n=0;n<Nrows;++n){
-    const dlong start = rowStarts[n];
-    const dlong end   = rowStarts[n+1];
-
-    for (int k=0;k<K;++k) {
-      T val = Op<T>().init();
-      for(dlong g=start;g<end;++g){
-        Op<T>()(val, v_ptr[k+colIds[g]*K]);
-      }
-      gv_ptr[k+n*K] = val;
-    }
-  }
+  GatherRows<Op, T>(Nrows, rowStarts, colIds, K, v_ptr, gv_ptr);
 }
 
 template <template<typename> class U,
@@ -155,6 +318,19 @@ template
 void ogsOperator_t::Gather(pinnedMemory<long long int> gv, const pinnedMemory<long long int> v,
                            const int k, const Op op, const Transpose trans);
 
+template
+void ogsOperator_t::Gather(memory<float> gv, const pinnedMemory<float> v,
+                           const int k, const Op op, const Transpose trans);
+template
+void ogsOperator_t::Gather(memory<double> gv, const pinnedMemory<double> v,
+                           const int k, const Op op, const Transpose trans);
+template
+void ogsOperator_t::Gather(memory<int> gv, const pinnedMemory<int> v,
+                           const int k, const Op op, const Transpose trans);
+template
+void ogsOperator_t::Gather(memory<long long int> gv, const pinnedMemory<long long int> v,
+                           const int k, const Op op, const Transpose trans);
+
 
 template<typename T>
 void ogsOperator_t::Gather(deviceMemory<T> o_gv,
@@ -224,17 +400,7 @@ void ogsOperator_t::Scatter(U<T> v, const V<T> gv,
   T* v_ptr  = v.ptr();
   const T* gv_ptr = gv.ptr();
 
-  #pragma omp parallel for
-  for(dlong n=0;n<Nrows;++n){
-    const dlong start = rowStarts[n];
-    const dlong end   = rowStarts[n+1];
-
-    for(dlong g=start;g<end;++g){
-      for (int k=0;k<K;++k) {
-        v_ptr[k+colIds[g]*K] = gv_ptr[k+n*K];
-      }
-    }
-  }
+  ScatterRows<T>(Nrows, rowStarts, colIds, K, v_ptr, gv_ptr);
 }
 
 template
@@ -263,6 +429,19 @@ template
 void ogsOperator_t::Scatter(memory<long long int> v, const pinnedMemory<long long int> gv,
                             const int K, const Transpose trans);
 
+template
+void ogsOperator_t::Scatter(pinnedMemory<float> v, const memory<float> gv,
+                            const int K, const Transpose trans);
+template
+void ogsOperator_t::Scatter(pinnedMemory<double> v, const memory<double> gv,
+                            const int K, const Transpose trans);
+template
+void ogsOperator_t::Scatter(pinnedMemory<int> v, const memory<int> gv,
+                            const int K, const Transpose trans);
+template
+void ogsOperator_t::Scatter(pinnedMemory<long long int> v, const memory<long long int> gv,
+                            const int K, const Transpose trans);
+
 template<typename T>
 void ogsOperator_t::Scatter(deviceMemory<T> o_v,
                             deviceMemory<T> o_gv,
@@ -340,23 +519,8 @@ void ogsOperator_t::GatherScatter(U<T> v, const int K,
 
   T* v_ptr = v.ptr();
 
-  #pragma omp parallel for
-  for(dlong n=0;n<Nrows;++n){
-    const dlong gstart = gRowStarts[n];
-    const dlong gend   = gRowStarts[n+1];
-    const dlong sstart = sRowStarts[n];
-    const dlong send   = sRowStarts[n+1];
-
-    for (int k=0;k<K;++k) {
-      T val = Op<T>().init();
-      for(dlong g=gstart;g<gend;++g){
-        Op<T>()(val, v_ptr[k+gColIds[g]*K]);
-      }
-      for(dlong s=sstart;s<send;++s){
-        v_ptr[k+sColIds[s]*K] = val;
-      }
-    }
-  }
+  GatherScatterRows<Op, T>(Nrows, gRowStarts, gColIds,
+                           sRowStarts, sColIds, K, v_ptr);
 }
 
 template <template<typename> class U,
@@ -444,8 +608,33 @@ template
 void ogsOperator_t::GatherScatter(deviceMemory<long long int> v,const int k,
                                   const Op op, const Transpose trans);
 
+//Copy a CSR row structure into fresh allocations, touching each row from
+// the thread the static schedules of the host kernels assign it to, so
+// pages are placed in that thread's local memory
+static void FirstTouch(memory<dlong> &rowStarts, memory<dlong> &colIds) {
+  if (rowStarts.length()==0) return;
+
+  const dlong Nrows = rowStarts.length()-1;
+  memory<dlong> newRowStarts(Nrows+1);
+  memory<dlong> newColIds(colIds.length());
+
+  #pragma omp parallel for schedule(static)
+  for (dlong n=0;n<Nrows;++n) {
+    newRowStarts[n] = rowStarts[n];
+    for (dlong g=rowStarts[n];g<rowStarts[n+1];++g)
+      newColIds[g] = colIds[g];
+  }
+  newRowStarts[Nrows] = rowStarts[Nrows];
+
+  rowStarts = newRowStarts;
+  colIds = newColIds;
+}
+
 void ogsOperator_t::setupRowBlocks() {
 
+  FirstTouch(rowStartsN, colIdsN);
+  FirstTouch(rowStartsT, colIdsT);
+
   dlong blockSumN=0, blockSumT=0;
   NrowBlocksN=0, NrowBlocksT=0;
 
@@ -549,11 +738,14 @@ void extract(const dlong N,
   const T* q_ptr = q.ptr();
   T* gatherq_ptr = gatherq.ptr();
 
+  #pragma omp parallel for schedule(static)
   for(dlong n=0;n<N;++n){
-    const dlong gid = ids[n];
+    const T* qn = q_ptr + ids[n]*K;
+    T* gatherqn = gatherq_ptr + n*K;
 
+    #pragma omp simd
     for (int k=0;k<K;++k) {
-      gatherq_ptr[k+n*K] = q_ptr[k+gid*K];
+      gatherqn[k] = qn[k];
     }
   }
 }
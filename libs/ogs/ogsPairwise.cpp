@@ -27,13 +27,7 @@ SOFTWARE.
 #include "ogs.hpp"
 #include "ogs/ogsUtils.hpp"
 #include "ogs/ogsExchange.hpp"
-
-#ifdef GLIBCXX_PARALLEL
-#include <parallel/algorithm>
-using __gnu_parallel::sort;
-#else
-using std::sort;
-#endif
+#include "radixSort.hpp"
 
 namespace libp {
 
@@ -42,6 +36,85 @@ namespace ogs {
 /**********************************
 * Host exchange
 ***********************************/
+//Derived datatypes for each peer's send list, built for each type, width
+// and send list (the NoTrans or Trans one) and cached. AllocBuffer builds
+// them for dfloat, other types are built on first use. For each peer, keep
+// whichever of the datatype and the explicit extract packs its entries faster
+template<typename T>
+ogsPairwise_t::sendTypes_t& ogsPairwise_t::SendTypes(pinnedMemory<T> &buf,
+                                                    const int k,
+                                                    const Transpose trans) {
+
+  auto key = std::make_tuple(static_cast<int>(ogsType<T>::get()), k,
+                             static_cast<int>((trans==NoTrans) ? NoTrans : Trans));
+  auto it = sendTypeCache.find(key);
+  if (it != sendTypeCache.end()) return *(it->second);
+
+  pinnedMemory<T> sendBuf = h_sendspace;
+
+  const int NranksSend  = (trans==NoTrans) ? NranksSendN  : NranksSendT;
+  const int *sendCounts = (trans==NoTrans) ? sendCountsN.ptr()  : sendCountsT.ptr();
+  const int *sendOffsets= (trans==NoTrans) ? sendOffsetsN.ptr() : sendOffsetsT.ptr();
+  memory<dlong> sendIds = (trans==NoTrans) ? sendIdsN : sendIdsT;
+
+  std::shared_ptr<sendTypes_t> st = std::make_shared<sendTypes_t>();
+  st->comm = comm;
+  st->types.malloc(NranksSend);
+  st->useType.malloc(NranksSend);
+
+  constexpr int Nreps = 6;
+
+  for (int r=0;r<NranksSend;r++) {
+    const int count = sendCounts[r];
+
+    memory<int> displacements(count);
+    for (int n=0;n<count;n++)
+      displacements[n] = static_cast<int>(sendIds[sendOffsets[r]+n]*k);
+
+    st->types[r] = comm.TypeIndexedBlock<T>(count, k, displacements.ptr());
+
+    //time both ways of packing this peer's entries. Each is warmed up
+    // first, and the order alternates so neither always runs on a cache
+    // the other just filled
+    memory<char> packBuf(static_cast<size_t>(count)*k*sizeof(T));
+
+    auto extractTime = [&]() {
+      timePoint_t start = Time();
+      extract(count, k, sendIds + sendOffsets[r], buf, sendBuf + sendOffsets[r]*k);
+      return ElapsedTime(start, Time());
+    };
+    auto packTime = [&]() {
+      timePoint_t start = Time();
+      comm.Pack(buf, st->types[r], packBuf);
+      return ElapsedTime(start, Time());
+    };
+
+    extractTime();
+    packTime();
+
+    double tExtract=0.0, tPack=0.0;
+    for (int n=0;n<Nreps;n++) {
+      if (n%2==0) {
+        tExtract += extractTime();
+        tPack    += packTime();
+      } else {
+        tPack    += packTime();
+        tExtract += extractTime();
+      }
+    }
+
+    st->useType[r] = (tPack <= tExtract) ? 1 : 0;
+  }
+
+  sendTypeCache[key] = st;
+  return *st;
+}
+
+ogsPairwise_t::sendTypes_t::~sendTypes_t() {
+  for (size_t r=0;r<types.length();r++)
+    comm.TypeFree(types[r]);
+}
+
 template<typename T>
 inline void ogsPairwise_t::Start(pinnedMemory<T> &buf, const int k,
                           const Op op, const Transpose trans){
@@ -56,30 +129,45 @@ inline void ogsPairwise_t::Start(pinnedMemory<T> &buf, const int k,
   const int *recvCounts = (trans==NoTrans) ? recvCountsN.ptr()  : recvCountsT.ptr();
   const int *sendOffsets= (trans==NoTrans) ? sendOffsetsN.ptr() : sendOffsetsT.ptr();
   const int *recvOffsets= (trans==NoTrans) ? recvOffsetsN.ptr() : recvOffsetsT.ptr();
+  memory<dlong> sendIds = (trans==NoTrans) ? sendIdsN : sendIdsT;
+
+  sendTypes_t& st = SendTypes(buf, k, trans);
 
   //post recvs
   for (int r=0;r<NranksRecv;r++) {
     comm.Irecv(buf + Nhalo*k + recvOffsets[r]*k,
                recvRanks[r],
                k*recvCounts[r],
-               recvRanks[r],
+               recvRanks[r]+tagOffset,
                requests[r]);
   }
 
-  // extract the send buffer
-  if (trans == NoTrans)
-    extract(NsendN, k, sendIdsN, buf, sendBuf);
-  else
-    extract(NsendT, k, sendIdsT, buf, sendBuf);
+  // extract the send buffer of peers not sent as derived datatypes
+  for (int r=0;r<NranksSend;r++) {
+    if (!st.useType[r])
+      extract(sendCounts[r], k, sendIds + sendOffsets[r], buf, sendBuf + sendOffsets[r]*k);
+  }
 
   //post sends
   for (int r=0;r<NranksSend;r++) {
-    comm.Isend(sendBuf + sendOffsets[r]*k,
-              sendRanks[r],
-              k*sendCounts[r],
-              rank,
-              requests[NranksRecv+r]);
+    if (st.useType[r]) {
+      comm.IsendType(buf,
+                     sendRanks[r],
+                     st.types[r],
+                     rank+tagOffset,
+                     requests[NranksRecv+r]);
+    } else {
+      comm.Isend(sendBuf + sendOffsets[r]*k,
+                sendRanks[r],
+                k*sendCounts[r],
+                rank+tagOffset,
+                requests[NranksRecv+r]);
+    }
+    RecordSend(sendRanks[r], k*sendCounts[r]*sizeof(T));
   }
+
+  Nposted = NranksRecv+NranksSend;
+  posted = true;
 }
 
 template<typename T>
@@ -90,7 +178,11 @@ inline void ogsPairwise_t::Finish(pinnedMemory<T> &buf, const int k,
   const int NranksRecv  = (trans==NoTrans) ? NranksRecvN  : NranksRecvT;
   const int *recvOffsets= (trans==NoTrans) ? recvOffsetsN.ptr() : recvOffsetsT.ptr();
 
+  timePoint_t wait = Time();
   comm.Waitall(NranksRecv+NranksSend, requests);
+  RecordWait(wait);
+  posted = false;
+  completed = false;
 
   //if we recvieved anything via MPI, gather the recv buffer and scatter
   // it back to to original vector
@@ -119,11 +211,20 @@ void ogsPairwise_t::Start(deviceMemory<T> &o_buf,
                           const Op op,
                           const Transpose trans){
 
+  deviceMemory<T> o_sendBuf = o_sendspace;
+
   const dlong Nsend = (trans == NoTrans) ? NsendN : NsendT;
 
-  if (Nsend) {
-    deviceMemory<T> o_sendBuf = o_sendspace;
+  const int NranksSend  = (trans==NoTrans) ? NranksSendN  : NranksSendT;
+  const int NranksRecv  = (trans==NoTrans) ? NranksRecvN  : NranksRecvT;
+  const int *sendRanks  = (trans==NoTrans) ? sendRanksN.ptr()   : sendRanksT.ptr();
+  const int *recvRanks  = (trans==NoTrans) ? recvRanksN.ptr()   : recvRanksT.ptr();
+  const int *sendCounts = (trans==NoTrans) ? sendCountsN.ptr()  : sendCountsT.ptr();
+  const int *recvCounts = (trans==NoTrans) ? recvCountsN.ptr()  : recvCountsT.ptr();
+  const int *sendOffsets= (trans==NoTrans) ? sendOffsetsN.ptr() : sendOffsetsT.ptr();
+  const int *recvOffsets= (trans==NoTrans) ? recvOffsetsN.ptr() : recvOffsetsT.ptr();
 
+  if (Nsend) {
     //  assemble the send buffer on device
     if (trans == NoTrans) {
       extractKernel[ogsType<T>::get()](NsendN, k, o_sendIdsN, o_buf, o_sendBuf);
@@ -134,6 +235,28 @@ void ogsPairwise_t::Start(deviceMemory<T> &o_buf,
     device_t &device = platform.device;
     device.finish();
   }
+
+  //post recvs
+  for (int r=0;r<NranksRecv;r++) {
+    comm.Irecv(o_buf + Nhalo*k + recvOffsets[r]*k,
+              recvRanks[r],
+              k*recvCounts[r],
+              recvRanks[r]+tagOffset,
+              requests[r]);
+  }
+
+  //post sends
+  for (int r=0;r<NranksSend;r++) {
+    comm.Isend(o_sendBuf + sendOffsets[r]*k,
+              sendRanks[r],
+              k*sendCounts[r],
+              rank+tagOffset,
+              requests[NranksRecv+r]);
+    RecordSend(sendRanks[r], k*sendCounts[r]*sizeof(T));
+  }
+
+  Nposted = NranksRecv+NranksSend;
+  posted = true;
 }
 
 template<typename T>
@@ -142,8 +265,49 @@ void ogsPairwise_t::Finish(deviceMemory<T> &o_buf,
                            const Op op,
                            const Transpose trans){
 
+  const int NranksSend  = (trans==NoTrans) ? NranksSendN  : NranksSendT;
+  const int NranksRecv  = (trans==NoTrans) ? NranksRecvN  : NranksRecvT;
+  const int *recvOffsets= (trans==NoTrans) ? recvOffsetsN.ptr() : recvOffsetsT.ptr();
+
+  timePoint_t wait = Time();
+  comm.Waitall(NranksRecv+NranksSend, requests);
+  RecordWait(wait);
+  posted = false;
+  completed = false;
+
+  //if we recvieved anything via MPI, gather the recv buffer and scatter
+  // it back to to original vector
+  dlong Nrecv = recvOffsets[NranksRecv];
+  if (Nrecv) {
+    // gather the recieved nodes on device
+    postmpi.Gather(o_buf, o_buf, k, op, trans);
+  }
+}
+
+void ogsPairwise_t::Start(deviceMemory<float> &buf, const int k, const Op op, const Transpose trans) { Start<float>(buf, k, op, trans); }
+void ogsPairwise_t::Start(deviceMemory<double> &buf, const int k, const Op op, const Transpose trans) { Start<double>(buf, k, op, trans); }
+void ogsPairwise_t::Start(deviceMemory<int> &buf, const int k, const Op op, const Transpose trans) { Start<int>(buf, k, op, trans); }
+void ogsPairwise_t::Start(deviceMemory<long long int> &buf, const int k, const Op op, const Transpose trans) { Start<long long int>(buf, k, op, trans); }
+void ogsPairwise_t::Finish(deviceMemory<float> &buf, const int k, const Op op, const Transpose trans) { Finish<float>(buf, k, op, trans); }
+void ogsPairwise_t::Finish(deviceMemory<double> &buf, const int k, const Op op, const Transpose trans) { Finish<double>(buf, k, op, trans); }
+void ogsPairwise_t::Finish(deviceMemory<int> &buf, const int k, const Op op, const Transpose trans) { Finish<int>(buf, k, op, trans); }
+void ogsPairwise_t::Finish(deviceMemory<long long int> &buf, const int k, const Op op, const Transpose trans) { Finish<long long int>(buf, k, op, trans); }
+
+/**********************************
+* Pipelined host staging
+***********************************/
+template<typename T>
+void ogsPairwise_t::StagedStart(deviceMemory<T> &o_buf,
+                                const int k,
+                                const Op op,
+                                const Transpose trans){
+
+  pinnedMemory<T> buf = h_workspace;
+  pinnedMemory<T> sendBuf = h_sendspace;
   deviceMemory<T> o_sendBuf = o_sendspace;
 
+  const dlong Nsend = (trans == NoTrans) ? NsendN : NsendT;
+
   const int NranksSend  = (trans==NoTrans) ? NranksSendN  : NranksSendT;
   const int NranksRecv  = (trans==NoTrans) ? NranksRecvN  : NranksRecvT;
   const int *sendRanks  = (trans==NoTrans) ? sendRanksN.ptr()   : sendRanksT.ptr();
@@ -153,25 +317,91 @@ void ogsPairwise_t::Finish(deviceMemory<T> &o_buf,
   const int *sendOffsets= (trans==NoTrans) ? sendOffsetsN.ptr() : sendOffsetsT.ptr();
   const int *recvOffsets= (trans==NoTrans) ? recvOffsetsN.ptr() : recvOffsetsT.ptr();
 
+  device_t &device = platform.device;
+
+  //  assemble the send buffer on device
+  if (Nsend) {
+    if (trans == NoTrans) {
+      extractKernel[ogsType<T>::get()](NsendN, k, o_sendIdsN, o_buf, o_sendBuf);
+    } else {
+      extractKernel[ogsType<T>::get()](NsendT, k, o_sendIdsT, o_buf, o_sendBuf);
+    }
+  }
+
+  //wait for the extract. This also retires the copies back to the device
+  // from the previous exchange, so the host buffers are free to reuse
+  device.waitFor(device.tagStream());
+
   //post recvs
   for (int r=0;r<NranksRecv;r++) {
-    comm.Irecv(o_buf + Nhalo*k + recvOffsets[r]*k,
-              recvRanks[r],
-              k*recvCounts[r],
-              recvRanks[r],
-              requests[r]);
+    comm.Irecv(buf + Nhalo*k + recvOffsets[r]*k,
+               recvRanks[r],
+               k*recvCounts[r],
+               recvRanks[r]+tagOffset,
+               requests[r]);
   }
 
-  //post sends
+  //queue one copy to host per peer, tagging each
+  stream_t currentStream = device.getStream();
+  device.setStream(dataStream);
   for (int r=0;r<NranksSend;r++) {
-    comm.Isend(o_sendBuf + sendOffsets[r]*k,
+    sendBuf.copyFrom(o_sendBuf + sendOffsets[r]*k,
+                     k*sendCounts[r],
+                     sendOffsets[r]*k, "async: true");
+    sendTags[r] = device.tagStream();
+  }
+  device.setStream(currentStream);
+
+  //post each send as soon as its chunk is on the host, while the
+  // copies for later peers are still in flight
+  for (int r=0;r<NranksSend;r++) {
+    device.waitFor(sendTags[r]);
+    comm.Isend(sendBuf + sendOffsets[r]*k,
               sendRanks[r],
               k*sendCounts[r],
-              rank,
+              rank+tagOffset,
               requests[NranksRecv+r]);
+    RecordSend(sendRanks[r], k*sendCounts[r]*sizeof(T));
   }
 
-  comm.Waitall(NranksRecv+NranksSend, requests);
+  Nposted = NranksRecv+NranksSend;
+  posted = true;
+}
+
+template<typename T>
+void ogsPairwise_t::StagedFinish(deviceMemory<T> &o_buf,
+                                 const int k,
+                                 const Op op,
+                                 const Transpose trans){
+
+  pinnedMemory<T> buf = h_workspace;
+
+  const int NranksSend  = (trans==NoTrans) ? NranksSendN  : NranksSendT;
+  const int NranksRecv  = (trans==NoTrans) ? NranksRecvN  : NranksRecvT;
+  const int *recvCounts = (trans==NoTrans) ? recvCountsN.ptr()  : recvCountsT.ptr();
+  const int *recvOffsets= (trans==NoTrans) ? recvOffsetsN.ptr() : recvOffsetsT.ptr();
+
+  //copy each received chunk back to the device as soon as it arrives.
+  // The copies are queued on the current stream, ahead of the gather below.
+  // If Ready already completed every request, copy them all back in order
+  for (int n=0;n<NranksRecv;n++) {
+    int r = n;
+    if (!completed) {
+      timePoint_t wait = Time();
+      r = comm.Waitany(NranksRecv, requests);
+      RecordWait(wait);
+    }
+    buf.copyTo(o_buf + Nhalo*k + recvOffsets[r]*k,
+               k*recvCounts[r],
+               Nhalo*k + recvOffsets[r]*k, "async: true");
+  }
+
+  memory<comm_t::request_t> sendRequests = requests + NranksRecv;
+  timePoint_t wait = Time();
+  comm.Waitall(NranksSend, sendRequests);
+  RecordWait(wait);
+  posted = false;
+  completed = false;
 
   //if we recvieved anything via MPI, gather the recv buffer and scatter
   // it back to to original vector
@@ -182,14 +412,22 @@ void ogsPairwise_t::Finish(deviceMemory<T> &o_buf,
   }
 }
 
-void ogsPairwise_t::Start(deviceMemory<float> &buf, const int k, const Op op, const Transpose trans) { Start<float>(buf, k, op, trans); }
-void ogsPairwise_t::Start(deviceMemory<double> &buf, const int k, const Op op, const Transpose trans) { Start<double>(buf, k, op, trans); }
-void ogsPairwise_t::Start(deviceMemory<int> &buf, const int k, const Op op, const Transpose trans) { Start<int>(buf, k, op, trans); }
-void ogsPairwise_t::Start(deviceMemory<long long int> &buf, const int k, const Op op, const Transpose trans) { Start<long long int>(buf, k, op, trans); }
-void ogsPairwise_t::Finish(deviceMemory<float> &buf, const int k, const Op op, const Transpose trans) { Finish<float>(buf, k, op, trans); }
-void ogsPairwise_t::Finish(deviceMemory<double> &buf, const int k, const Op op, const Transpose trans) { Finish<double>(buf, k, op, trans); }
-void ogsPairwise_t::Finish(deviceMemory<int> &buf, const int k, const Op op, const Transpose trans) { Finish<int>(buf, k, op, trans); }
-void ogsPairwise_t::Finish(deviceMemory<long long int> &buf, const int k, const Op op, const Transpose trans) { Finish<long long int>(buf, k, op, trans); }
+void ogsPairwise_t::StagedStart(deviceMemory<float> &buf, const int k, const Op op, const Transpose trans) { StagedStart<float>(buf, k, op, trans); }
+void ogsPairwise_t::StagedStart(deviceMemory<double> &buf, const int k, const Op op, const Transpose trans) { StagedStart<double>(buf, k, op, trans); }
+void ogsPairwise_t::StagedStart(deviceMemory<int> &buf, const int k, const Op op, const Transpose trans) { StagedStart<int>(buf, k, op, trans); }
+void ogsPairwise_t::StagedStart(deviceMemory<long long int> &buf, const int k, const Op op, const Transpose trans) { StagedStart<long long int>(buf, k, op, trans); }
+void ogsPairwise_t::StagedFinish(deviceMemory<float> &buf, const int k, const Op op, const Transpose trans) { StagedFinish<float>(buf, k, op, trans); }
+void ogsPairwise_t::StagedFinish(deviceMemory<double> &buf, const int k, const Op op, const Transpose trans) { StagedFinish<double>(buf, k, op, trans); }
+void ogsPairwise_t::StagedFinish(deviceMemory<int> &buf, const int k, const Op op, const Transpose trans) { StagedFinish<int>(buf, k, op, trans); }
+void ogsPairwise_t::StagedFinish(deviceMemory<long long int> &buf, const int k, const Op op, const Transpose trans) { StagedFinish<long long int>(buf, k, op, trans); }
+
+//test the requests posted by Start. MPI_Testall completes all of them or
+// none, so Finish knows from completed whether any are left to wait on
+bool ogsPairwise_t::Ready() {
+  if (!posted) return false;
+  if (!completed) completed = comm.Testall(Nposted, requests);
+  return completed;
+}
 
 ogsPairwise_t::ogsPairwise_t(dlong Nshared,
                              memory<parallelNode_t> &sharedNodes,
@@ -203,13 +441,9 @@ ogsPairwise_t::ogsPairwise_t(dlong Nshared,
   NhaloP = gatherHalo.NrowsN;
 
   // sort the list by rank to the order where they will be sent by MPI_Allgatherv
-  sort(sharedNodes.ptr(), sharedNodes.ptr()+Nshared,
-       [](const parallelNode_t& a, const parallelNode_t& b) {
-         if(a.rank < b.rank) return true; //group by rank
-         if(a.rank > b.rank) return false;
-
-         return a.newId < b.newId; //then order by the localId relative to this rank
-       });
+  RadixSort(Nshared, sharedNodes,
+            [](const parallelNode_t& a) { return static_cast<uint64_t>(a.rank); }, //group by rank
+            [](const parallelNode_t& a) { return static_cast<uint64_t>(a.newId); }); //then order by the localId relative to this rank
 
   //make mpi allgatherv counts and offsets
   memory<int> mpiSendCountsT(size,0);
@@ -227,20 +461,29 @@ ogsPairwise_t::ogsPairwise_t(dlong Nshared,
     mpiSendCountsT[r]++;
   }
 
-  //shared counts
-  comm.Alltoall(mpiSendCountsT, mpiRecvCountsT);
-  comm.Alltoall(mpiSendCountsN, mpiRecvCountsN);
+  mpiSendOffsetsT[0] = 0;
+  for (int r=0;r<size;r++)
+    mpiSendOffsetsT[r+1] = mpiSendOffsetsT[r]+mpiSendCountsT[r];
+
+  //Send list of nodes to each rank. Only the ranks we share nodes with are
+  // contacted, and the positive node counts can be read off the nodes we recv
+  memory<parallelNode_t> recvNodes;
+  comm.SparseAlltoallv(sharedNodes, mpiSendCountsT, mpiSendOffsetsT,
+                         recvNodes, mpiRecvCountsT, mpiRecvOffsetsT);
+  dlong Nrecv = mpiRecvOffsetsT[size];
+
+  for (int r=0;r<size;r++) {
+    mpiRecvCountsN[r] = 0;
+    for (int n=mpiRecvOffsetsT[r];n<mpiRecvOffsetsT[r+1];n++)
+      if (recvNodes[n].sign>0) mpiRecvCountsN[r]++;
+  }
 
   //cumulative sum
   mpiSendOffsetsN[0] = 0;
-  mpiSendOffsetsT[0] = 0;
   mpiRecvOffsetsN[0] = 0;
-  mpiRecvOffsetsT[0] = 0;
   for (int r=0;r<size;r++) {
     mpiSendOffsetsN[r+1] = mpiSendOffsetsN[r]+mpiSendCountsN[r];
-    mpiSendOffsetsT[r+1] = mpiSendOffsetsT[r]+mpiSendCountsT[r];
     mpiRecvOffsetsN[r+1] = mpiRecvOffsetsN[r]+mpiRecvCountsN[r];
-    mpiRecvOffsetsT[r+1] = mpiRecvOffsetsT[r]+mpiRecvCountsT[r];
   }
 
   //make ops for scattering halo nodes before sending
@@ -263,14 +506,6 @@ ogsPairwise_t::ogsPairwise_t(dlong Nshared,
   o_sendIdsT = platform.malloc(sendIdsT);
   o_sendIdsN = platform.malloc(sendIdsN);
 
-  //send the node lists so we know what we'll receive
-  dlong Nrecv = mpiRecvOffsetsT[size];
-  memory<parallelNode_t> recvNodes(Nrecv);
-
-  //Send list of nodes to each rank
-  comm.Alltoallv(sharedNodes, mpiSendCountsT, mpiSendOffsetsT,
-                   recvNodes, mpiRecvCountsT, mpiRecvOffsetsT);
-
   //make ops for gathering halo nodes after an MPI_Allgatherv
   postmpi.platform = platform;
   postmpi.kind = Signed;
@@ -410,6 +645,11 @@ ogsPairwise_t::ogsPairwise_t(dlong Nshared,
 
   requests.malloc(NranksSendT+NranksRecvT);
 
+  //when not using gpu-aware MPI, stage the exchange through the host one
+  // peer at a time so copies overlap with the messages of other peers
+  staged = true;
+  sendTags.malloc(NranksSendT);
+
   //make scratch space
   AllocBuffer(sizeof(dfloat));
 }
@@ -423,6 +663,28 @@ void ogsPairwise_t::AllocBuffer(size_t Nbytes) {
     h_sendspace = platform.hostMalloc<char>(NsendT*Nbytes);
     o_sendspace = platform.malloc<char>(NsendT*Nbytes);
   }
+
+  //build the send datatypes for dfloat exchanges of this width here, during
+  // setup and tuning, rather than in the first Start that needs them
+  if (Nbytes % sizeof(dfloat) == 0) {
+    pinnedMemory<dfloat> buf = h_workspace;
+    const int k = static_cast<int>(Nbytes/sizeof(dfloat));
+    SendTypes(buf, k, NoTrans);
+    SendTypes(buf, k, Trans);
+  }
+}
+
+ogsExchange_t* ogsPairwise_t::Clone() {
+  ogsPairwise_t* clone = new ogsPairwise_t(*this);
+
+  //private buffers and requests, allocated on first use
+  clone->h_workspace = pinnedMemory<char>();
+  clone->o_workspace = deviceMemory<char>();
+  clone->h_sendspace = pinnedMemory<char>();
+  clone->o_sendspace = deviceMemory<char>();
+  clone->requests.malloc(NranksSendT+NranksRecvT);
+  clone->sendTags.malloc(NranksSendT);
+  return clone;
 }
 
 } //namespace ogs
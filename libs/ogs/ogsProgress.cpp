@@ -0,0 +1,92 @@
+/*
+
+The MIT License (MIT)
+
+Copyright (c) 2017-2022 Tim Warburton, Noel Chalmers, Jesse Chan, Ali Karakus
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+*/
+
+#include "ogs.hpp"
+#include <thread>
+#include <atomic>
+#include <chrono>
+
+namespace libp {
+
+namespace ogs {
+
+/*
+  Many MPI implementations only progress non-blocking messages while the
+  application is inside an MPI call. When enabled, a thread polls MPI while
+  any ogs exchange is between its Start and Finish, so messages move while
+  the host is busy with local work. The thread drives MPI's progress engine
+  with probes on its own communicator and never touches the exchanges'
+  requests, which MPI does not allow to be completed from two threads.
+*/
+
+static std::thread progressThread;
+static std::atomic<bool> progressStop{false};
+static std::atomic<int> progressActive{0};
+static comm_t progressComm;
+
+static void ProgressLoop(comm_t comm) {
+  while (!progressStop.load(std::memory_order_acquire)) {
+    if (progressActive.load(std::memory_order_acquire) > 0) {
+      comm.Poll();
+      std::this_thread::yield();
+    } else {
+      std::this_thread::sleep_for(std::chrono::microseconds(20));
+    }
+  }
+}
+
+void StartProgressThread(comm_t comm) {
+  if (progressThread.joinable()) return;
+
+  const bool threadMultiple = comm_t::ThreadMultiple();
+  LIBP_WARNING("ogs progress thread requires MPI_THREAD_MULTIPLE, running without it",
+               !threadMultiple);
+  if (!threadMultiple) return;
+
+  progressComm = comm.Dup();
+  progressStop.store(false, std::memory_order_release);
+  progressThread = std::thread(ProgressLoop, progressComm);
+}
+
+void StopProgressThread() {
+  if (!progressThread.joinable()) return;
+
+  progressStop.store(true, std::memory_order_release);
+  progressThread.join();
+  progressComm.Free();
+}
+
+void ProgressBegin() {
+  progressActive.fetch_add(1, std::memory_order_acq_rel);
+}
+
+void ProgressEnd() {
+  progressActive.fetch_sub(1, std::memory_order_acq_rel);
+}
+
+} //namespace ogs
+
+} //namespace libp
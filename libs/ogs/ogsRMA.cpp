@@ -0,0 +1,268 @@
+/*
+
+The MIT License (MIT)
+
+Copyright (c) 2017-2022 Tim Warburton, Noel Chalmers, Jesse Chan, Ali Karakus
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+*/
+
+#include "ogs.hpp"
+#include "ogs/ogsUtils.hpp"
+#include "ogs/ogsExchange.hpp"
+
+namespace libp {
+
+namespace ogs {
+
+/**********************************
+* Host exchange
+***********************************/
+template<typename T>
+inline void ogsRMA_t::Start(pinnedMemory<T> &buf, const int k,
+                            const Op op, const Transpose trans){
+
+  pinnedMemory<T> sendBuf = h_sendspace;
+
+  const int NranksSend  = (trans==NoTrans) ? NranksSendN  : NranksSendT;
+  const int *sendRanks  = (trans==NoTrans) ? sendRanksN.ptr()   : sendRanksT.ptr();
+  const int *sendCounts = (trans==NoTrans) ? sendCountsN.ptr()  : sendCountsT.ptr();
+  const int *sendOffsets= (trans==NoTrans) ? sendOffsetsN.ptr() : sendOffsetsT.ptr();
+  const int *putDisps   = (trans==NoTrans) ? putDispsN.ptr()    : putDispsT.ptr();
+  comm_t::group_t originGroup = (trans==NoTrans) ? originGroupN : originGroupT;
+  comm_t::group_t targetGroup = (trans==NoTrans) ? targetGroupN : targetGroupT;
+
+  // extract the send buffer
+  if (trans == NoTrans)
+    extract(NsendN, k, sendIdsN, buf, sendBuf);
+  else
+    extract(NsendT, k, sendIdsT, buf, sendBuf);
+
+  //expose our recv region to the ranks which will put into it
+  comm.WinPost(originGroup, h_win);
+
+  //put directly into the recv region of each neighbour
+  comm.WinStart(targetGroup, h_win);
+  for (int r=0;r<NranksSend;r++) {
+    comm.Put(sendBuf + sendOffsets[r]*k,
+             sendRanks[r],
+             k*sendCounts[r],
+             static_cast<size_t>(putDisps[r])*k*sizeof(T),
+             h_win);
+    RecordSend(sendRanks[r], k*sendCounts[r]*sizeof(T));
+  }
+}
+
+template<typename T>
+inline void ogsRMA_t::Finish(pinnedMemory<T> &buf, const int k,
+                             const Op op, const Transpose trans){
+
+  const int NranksRecv  = (trans==NoTrans) ? NranksRecvN  : NranksRecvT;
+  const int *recvOffsets= (trans==NoTrans) ? recvOffsetsN.ptr() : recvOffsetsT.ptr();
+
+  //close our access epoch and wait for all puts into our window
+  timePoint_t wait = Time();
+  comm.WinComplete(h_win);
+  comm.WinWait(h_win);
+  RecordWait(wait);
+
+  //if we recvieved anything via MPI, gather the recv buffer and scatter
+  // it back to to original vector
+  dlong Nrecv = recvOffsets[NranksRecv];
+  if (Nrecv) {
+    // gather the recieved nodes
+    postmpi.Gather(buf, buf, k, op, trans);
+  }
+}
+
+void ogsRMA_t::Start(pinnedMemory<float> &buf, const int k, const Op op, const Transpose trans) { Start<float>(buf, k, op, trans); }
+void ogsRMA_t::Start(pinnedMemory<double> &buf, const int k, const Op op, const Transpose trans) { Start<double>(buf, k, op, trans); }
+void ogsRMA_t::Start(pinnedMemory<int> &buf, const int k, const Op op, const Transpose trans) { Start<int>(buf, k, op, trans); }
+void ogsRMA_t::Start(pinnedMemory<long long int> &buf, const int k, const Op op, const Transpose trans) { Start<long long int>(buf, k, op, trans); }
+void ogsRMA_t::Finish(pinnedMemory<float> &buf, const int k, const Op op, const Transpose trans) { Finish<float>(buf, k, op, trans); }
+void ogsRMA_t::Finish(pinnedMemory<double> &buf, const int k, const Op op, const Transpose trans) { Finish<double>(buf, k, op, trans); }
+void ogsRMA_t::Finish(pinnedMemory<int> &buf, const int k, const Op op, const Transpose trans) { Finish<int>(buf, k, op, trans); }
+void ogsRMA_t::Finish(pinnedMemory<long long int> &buf, const int k, const Op op, const Transpose trans) { Finish<long long int>(buf, k, op, trans); }
+
+/**********************************
+* GPU-aware exchange
+***********************************/
+template<typename T>
+void ogsRMA_t::Start(deviceMemory<T> &o_buf,
+                     const int k,
+                     const Op op,
+                     const Transpose trans){
+
+  const dlong Nsend = (trans == NoTrans) ? NsendN : NsendT;
+
+  if (Nsend) {
+    deviceMemory<T> o_sendBuf = o_sendspace;
+
+    //  assemble the send buffer on device
+    if (trans == NoTrans) {
+      extractKernel[ogsType<T>::get()](NsendN, k, o_sendIdsN, o_buf, o_sendBuf);
+    } else {
+      extractKernel[ogsType<T>::get()](NsendT, k, o_sendIdsT, o_buf, o_sendBuf);
+    }
+    //wait for kernel to finish on default stream
+    device_t &device = platform.device;
+    device.finish();
+  }
+}
+
+template<typename T>
+void ogsRMA_t::Finish(deviceMemory<T> &o_buf,
+                      const int k,
+                      const Op op,
+                      const Transpose trans){
+
+  deviceMemory<T> o_sendBuf = o_sendspace;
+
+  const int NranksSend  = (trans==NoTrans) ? NranksSendN  : NranksSendT;
+  const int NranksRecv  = (trans==NoTrans) ? NranksRecvN  : NranksRecvT;
+  const int *sendRanks  = (trans==NoTrans) ? sendRanksN.ptr()   : sendRanksT.ptr();
+  const int *sendCounts = (trans==NoTrans) ? sendCountsN.ptr()  : sendCountsT.ptr();
+  const int *sendOffsets= (trans==NoTrans) ? sendOffsetsN.ptr() : sendOffsetsT.ptr();
+  const int *recvOffsets= (trans==NoTrans) ? recvOffsetsN.ptr() : recvOffsetsT.ptr();
+  const int *putDisps   = (trans==NoTrans) ? putDispsN.ptr()    : putDispsT.ptr();
+  comm_t::group_t originGroup = (trans==NoTrans) ? originGroupN : originGroupT;
+  comm_t::group_t targetGroup = (trans==NoTrans) ? targetGroupN : targetGroupT;
+
+  //expose our recv region to the ranks which will put into it
+  comm.WinPost(originGroup, o_win);
+
+  //put directly into the recv region of each neighbour
+  comm.WinStart(targetGroup, o_win);
+  for (int r=0;r<NranksSend;r++) {
+    comm.Put(o_sendBuf + sendOffsets[r]*k,
+             sendRanks[r],
+             k*sendCounts[r],
+             static_cast<size_t>(putDisps[r])*k*sizeof(T),
+             o_win);
+    RecordSend(sendRanks[r], k*sendCounts[r]*sizeof(T));
+  }
+
+  timePoint_t wait = Time();
+  comm.WinComplete(o_win);
+  comm.WinWait(o_win);
+  RecordWait(wait);
+
+  //if we recvieved anything via MPI, gather the recv buffer and scatter
+  // it back to to original vector
+  dlong Nrecv = recvOffsets[NranksRecv];
+  if (Nrecv) {
+    // gather the recieved nodes on device
+    postmpi.Gather(o_buf, o_buf, k, op, trans);
+  }
+}
+
+void ogsRMA_t::Start(deviceMemory<float> &buf, const int k, const Op op, const Transpose trans) { Start<float>(buf, k, op, trans); }
+void ogsRMA_t::Start(deviceMemory<double> &buf, const int k, const Op op, const Transpose trans) { Start<double>(buf, k, op, trans); }
+void ogsRMA_t::Start(deviceMemory<int> &buf, const int k, const Op op, const Transpose trans) { Start<int>(buf, k, op, trans); }
+void ogsRMA_t::Start(deviceMemory<long long int> &buf, const int k, const Op op, const Transpose trans) { Start<long long int>(buf, k, op, trans); }
+void ogsRMA_t::Finish(deviceMemory<float> &buf, const int k, const Op op, const Transpose trans) { Finish<float>(buf, k, op, trans); }
+void ogsRMA_t::Finish(deviceMemory<double> &buf, const int k, const Op op, const Transpose trans) { Finish<double>(buf, k, op, trans); }
+void ogsRMA_t::Finish(deviceMemory<int> &buf, const int k, const Op op, const Transpose trans) { Finish<int>(buf, k, op, trans); }
+void ogsRMA_t::Finish(deviceMemory<long long int> &buf, const int k, const Op op, const Transpose trans) { Finish<long long int>(buf, k, op, trans); }
+
+ogsRMA_t::ogsRMA_t(dlong Nshared,
+                   memory<parallelNode_t> &sharedNodes,
+                   ogsOperator_t& gatherHalo,
+                   stream_t _dataStream,
+                   comm_t _comm,
+                   platform_t &_platform):
+  ogsPairwise_t(Nshared, sharedNodes, gatherHalo,
+                _dataStream, _comm, _platform) {
+
+  //one-sided puts do not use the pairwise staging pipeline
+  staged = false;
+
+  //the pairwise setup gives us the send/recv lists. Since the pattern is
+  // static, each rank can tell its neighbours up front where their data
+  // lands in its workspace, so no receive matching is needed later
+  memory<int> recvDispsN(NranksRecvN);
+  memory<int> recvDispsT(NranksRecvT);
+  for (int r=0;r<NranksRecvN;r++) recvDispsN[r] = Nhalo + recvOffsetsN[r];
+  for (int r=0;r<NranksRecvT;r++) recvDispsT[r] = Nhalo + recvOffsetsT[r];
+
+  putDispsN.malloc(NranksSendN);
+  putDispsT.malloc(NranksSendT);
+
+  //only neighbours need to swap displacements
+  memory<comm_t::request_t> dispRequests(NranksSendN+NranksSendT
+                                         +NranksRecvN+NranksRecvT);
+  int Nrequests=0;
+  for (int r=0;r<NranksSendN;r++)
+    comm.Irecv(putDispsN[r], sendRanksN[r], 0, dispRequests[Nrequests++]);
+  for (int r=0;r<NranksSendT;r++)
+    comm.Irecv(putDispsT[r], sendRanksT[r], 1, dispRequests[Nrequests++]);
+  for (int r=0;r<NranksRecvN;r++)
+    comm.Isend(recvDispsN[r], recvRanksN[r], 0, dispRequests[Nrequests++]);
+  for (int r=0;r<NranksRecvT;r++)
+    comm.Isend(recvDispsT[r], recvRanksT[r], 1, dispRequests[Nrequests++]);
+  comm.Waitall(Nrequests, dispRequests);
+
+  //groups for the PSCW epochs. Only neighbours synchronize, unlike a fence
+  originGroupN = comm.GroupIncl(NranksRecvN, recvRanksN);
+  originGroupT = comm.GroupIncl(NranksRecvT, recvRanksT);
+  targetGroupN = comm.GroupIncl(NranksSendN, sendRanksN);
+  targetGroupT = comm.GroupIncl(NranksSendT, sendRanksT);
+
+  //make scratch space and expose it
+  AllocBuffer(sizeof(dfloat));
+}
+
+ogsRMA_t::~ogsRMA_t() {
+  FreeWindows();
+  comm.GroupFree(originGroupN);
+  comm.GroupFree(originGroupT);
+  comm.GroupFree(targetGroupN);
+  comm.GroupFree(targetGroupT);
+}
+
+void ogsRMA_t::FreeWindows() {
+  if (h_winCreated) comm.WinFree(h_win);
+  if (o_winCreated) comm.WinFree(o_win);
+  h_winCreated = false;
+  o_winCreated = false;
+}
+
+void ogsRMA_t::AllocBuffer(size_t Nbytes) {
+  //window creation is collective, so regrow on the word size (which
+  // every rank agrees on) rather than on this rank's buffer sizes
+  if (Nbytes <= NbytesWin) return;
+
+  FreeWindows();
+
+  ogsPairwise_t::AllocBuffer(Nbytes);
+
+  comm.WinCreate(h_workspace, h_win);
+  h_winCreated = true;
+#ifdef GPU_AWARE_MPI
+  comm.WinCreate(o_workspace, o_win);
+  o_winCreated = true;
+#endif
+
+  NbytesWin = Nbytes;
+}
+
+} //namespace ogs
+
+} //namespace libp
@@ -0,0 +1,101 @@
+/*
+
+The MIT License (MIT)
+
+Copyright (c) 2017-2022 Tim Warburton, Noel Chalmers, Jesse Chan, Ali Karakus
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+*/
+
+#include "ogs.hpp"
+
+namespace libp {
+
+void ogsAddSettings(settings_t& settings) {
+
+  settings.newSetting("-oc", "--ogs-cache",
+                      "OGS AUTO CACHE",
+                      "NONE",
+                      "File used to cache ogs exchange method auto-tuning results");
+
+  settings.newSetting("-or", "--ogs-retune",
+                      "OGS AUTO RETUNE",
+                      "FALSE",
+                      "Force re-tuning of ogs exchange methods found in the cache",
+                      {"TRUE", "FALSE"});
+
+  settings.newSetting("-ori", "--ogs-retune-interval",
+                      "OGS RETUNE INTERVAL",
+                      "0",
+                      "Number of exchanges between online re-trials of ogs exchange methods (0 to disable)");
+
+  settings.newSetting("-opt", "--ogs-progress-thread",
+                      "OGS PROGRESS THREAD",
+                      "FALSE",
+                      "Poll MPI from a separate thread while ogs exchanges are in flight (needs MPI_THREAD_MULTIPLE)",
+                      {"TRUE", "FALSE"});
+
+  settings.newSetting("-oop", "--ogs-owner-policy",
+                      "OGS OWNER POLICY",
+                      "BALANCE",
+                      "How owners of shared nodes are chosen in unique ogs setups",
+                      {"BALANCE", "COMMUNICATION"});
+
+  settings.newSetting("-osb", "--ogs-setup-batch",
+                      "OGS SETUP BATCH",
+                      "4194304",
+                      "Maximum number of ids each rank exchanges at once during ogs setup (0 for no limit)");
+
+  settings.newSetting("-oht", "--ogs-hybrid-threshold",
+                      "OGS HYBRID THRESHOLD",
+                      "256",
+                      "Nodes a neighbour must share to get pairwise messages in the ogs Hybrid exchange");
+
+  settings.newSetting("-ost", "--ogs-stats",
+                      "OGS STATS",
+                      "FALSE",
+                      "Record and report per-neighbour ogs exchange statistics",
+                      {"TRUE", "FALSE"});
+
+  settings.newSetting("-ocm", "--ogs-comm-matrix",
+                      "OGS COMM MATRIX",
+                      "NONE",
+                      "CSV file for the rank-by-rank matrix of bytes sent by ogs exchanges");
+}
+
+void ogsReportSettings(settings_t& settings) {
+
+  settings.reportSetting("OGS AUTO CACHE");
+
+  if (!settings.compareSetting("OGS AUTO CACHE","NONE"))
+    settings.reportSetting("OGS AUTO RETUNE");
+
+  settings.reportSetting("OGS RETUNE INTERVAL");
+  settings.reportSetting("OGS PROGRESS THREAD");
+  settings.reportSetting("OGS OWNER POLICY");
+  settings.reportSetting("OGS SETUP BATCH");
+  settings.reportSetting("OGS HYBRID THRESHOLD");
+  settings.reportSetting("OGS STATS");
+
+  if (settings.compareSetting("OGS STATS","TRUE"))
+    settings.reportSetting("OGS COMM MATRIX");
+}
+
+} //namespace libp
@@ -29,13 +29,9 @@ SOFTWARE.
 #include "ogs/ogsOperator.hpp"
 #include "ogs/ogsExchange.hpp"
 #include "timer.hpp"
-
-#ifdef GLIBCXX_PARALLEL
-#include <parallel/algorithm>
-using __gnu_parallel::sort;
-#else
-using std::sort;
-#endif
+#include "radixSort.hpp"
+#include <sys/resource.h>
+#include <fstream>
 
 namespace libp {
 
@@ -48,8 +44,9 @@ void ogs_t::Setup(const dlong _N,
                   const Method method,
                   const bool _unique,
                   const bool verbose,
-                  platform_t& _platform){
-  ogsBase_t::Setup(_N, ids, _comm, _kind, method, _unique, verbose, _platform);
+                  platform_t& _platform,
+                  const std::vector<exchangeConfig_t> configs){
+  ogsBase_t::Setup(_N, ids, _comm, _kind, method, _unique, verbose, _platform, configs);
 }
 
 void halo_t::Setup(const dlong _N,
@@ -57,12 +54,127 @@ void halo_t::Setup(const dlong _N,
                   comm_t _comm,
                   const Method method,
                   const bool verbose,
-                  platform_t& _platform){
-  ogsBase_t::Setup(_N, ids, _comm, Halo, method, false, verbose, _platform);
+                  platform_t& _platform,
+                  const std::vector<exchangeConfig_t> configs){
+  ogsBase_t::Setup(_N, ids, _comm, Halo, method, false, verbose, _platform, configs);
 
   Nhalo = NhaloT - NhaloP; //number of extra recieved nodes
 }
 
+//maximum number of nodes each rank rendezvous in one batch during setup
+static dlong SetupBatchSize(platform_t& platform) {
+  settings_t& settings = platform.settings();
+  if (settings.settings.find("OGS SETUP BATCH") == settings.settings.end())
+    return 0;
+
+  dlong batchSize;
+  settings.getSetting("OGS SETUP BATCH", batchSize);
+  return batchSize;
+}
+
+//peer size threshold of the Hybrid exchange when it is not tuned
+static dlong HybridThreshold(platform_t& platform) {
+  settings_t& settings = platform.settings();
+  if (settings.settings.find("OGS HYBRID THRESHOLD") == settings.settings.end())
+    return 256;
+
+  dlong threshold;
+  settings.getSetting("OGS HYBRID THRESHOLD", threshold);
+  return threshold;
+}
+
+//order-sensitive hash of an id list. Signs are ignored for unique setups,
+// since those write the owner flags back into the ids
+static uint64_t IdsHash(const dlong N, const memory<hlong> ids, const bool unique) {
+  uint64_t h = 0xCBF29CE484222325ULL;
+  for (dlong n=0;n<N;n++) {
+    const hlong id = unique ? abs(ids[n]) : ids[n];
+    h = (h ^ static_cast<uint64_t>(id)) * 0x100000001B3ULL;
+  }
+  return h;
+}
+
+//hash of the node list fields the local gather operators are built from
+static uint64_t NodesHash(const dlong Nids, const memory<parallelNode_t> nodes) {
+  uint64_t h = 0xCBF29CE484222325ULL;
+  for (dlong n=0;n<Nids;n++) {
+    h = (h ^ static_cast<uint64_t>(nodes[n].localId)) * 0x100000001B3ULL;
+    h = (h ^ static_cast<uint64_t>(nodes[n].newId)) * 0x100000001B3ULL;
+    h = (h ^ static_cast<uint64_t>(nodes[n].sign)) * 0x100000001B3ULL;
+    h = (h ^ static_cast<uint64_t>(nodes[n].baseId>0)) * 0x100000001B3ULL;
+  }
+  return h;
+}
+
+//a field of /proc/self/status in kilobytes, or -1 if it can't be read
+static hlong StatusKB(const std::string field) {
+  std::ifstream status("/proc/self/status");
+  std::string line;
+  while (std::getline(status, line)) {
+    if (line.compare(0, field.size()+1, field+":")==0)
+      return static_cast<hlong>(std::stoll(line.substr(field.size()+1)));
+  }
+  return -1;
+}
+
+//memory use at the start of a setup phase. Where /proc/self/clear_refs
+// allows it, the kernel's high-water mark is reset so that VmHWM is the
+// phase's own peak. Otherwise only the growth of the process high-water
+// mark over the phase can be measured
+struct setupPhase_t {
+  hlong startRSS=0;  //kilobytes
+  hlong startPeak=0;
+  bool reset=false;
+};
+
+static setupPhase_t StartSetupPhase() {
+  setupPhase_t phase;
+
+  std::ofstream clearRefs("/proc/self/clear_refs");
+  if (clearRefs) {
+    clearRefs << "5";
+    clearRefs.close();
+    phase.reset = !clearRefs.fail();
+  }
+  phase.startRSS = StatusKB("VmRSS");
+  if (phase.startRSS<0) phase.reset = false;
+
+  struct rusage usage;
+  getrusage(RUSAGE_SELF, &usage);
+  phase.startPeak = static_cast<hlong>(usage.ru_maxrss);
+  return phase;
+}
+
+//report the largest peak of a setup phase over all ranks, and its growth
+// above the memory in use when the phase started
+static void ReportPhaseMemory(comm_t comm, const std::string name,
+                              const setupPhase_t phase) {
+  memory<hlong> kb(3);
+  if (phase.reset) {
+    kb[0] = StatusKB("VmHWM");
+    kb[1] = kb[0]-phase.startRSS;
+    kb[2] = 0;
+  } else {
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    kb[0] = 0;
+    kb[1] = static_cast<hlong>(usage.ru_maxrss)-phase.startPeak;
+    kb[2] = 1;
+  }
+  comm.Reduce(kb, 0, comm_t::Max);
+
+  if (!comm.rank()) {
+    if (kb[2]) {
+      std::cout << "ogs Setup: " << name << " raised the peak memory by "
+                << kb[1]/1024 << " MB (max per rank)." << std::endl;
+    } else {
+      std::cout << "ogs Setup: " << name << " peak memory "
+                << kb[0]/1024 << " MB, " << kb[1]/1024
+                << " MB above its start (max per rank)." << std::endl;
+    }
+  }
+}
+
 /********************************
  * Setup
  ********************************/
@@ -73,7 +185,8 @@ void ogsBase_t::Setup(const dlong _N,
                       const Method method,
                       const bool _unique,
                       const bool verbose,
-                      platform_t& _platform){
+                      platform_t& _platform,
+                      const std::vector<exchangeConfig_t> configs){
 
   //release resources if this ogs was setup before
   Free();
@@ -82,27 +195,111 @@ void ogsBase_t::Setup(const dlong _N,
 
   platform = _platform;
 
-  if (!dataStream.isInitialized())
-      dataStream = platform.device.createStream();
+  dataStream = platform.device.createStream();
 
   N = _N;
   comm = _comm;
   kind = _kind;
   unique = _unique;
 
-  int rank, size;
-  rank = comm.rank();
-  size = comm.size();
+  int rank = comm.rank();
 
   //sanity check options
   LIBP_ABORT("Invalid ogs setup requested",
              (kind==Unsigned && unique==true)
               || (kind==Halo && unique==true));
 
+  setupMethod = method;
+  idsHash = IdsHash(N, ids, unique);
+
+  BuildOperators(ids, method, configs, verbose, false);
+
+  timePoint_t end = GlobalPlatformTime(platform);
+  double elapsedTime = ElapsedTime(start, end);
+
+  if (!rank && verbose) {
+    std::cout << "ogs Setup Time: " << elapsedTime << " seconds." << std::endl;
+  }
+}
+
+/********************************
+ * Update
+ ********************************/
+void ogsBase_t::Update(const dlong _N,
+                       memory<hlong> ids,
+                       const bool verbose) {
+
+  LIBP_ABORT("ogs handle must be set up before it is updated",
+             exchange==nullptr);
+
+  timePoint_t start = Time();
+
+  int rank = comm.rank();
+
+  //nothing to rebuild if no rank's ids changed
+  const uint64_t hash = IdsHash(_N, ids, unique);
+  int changed = (_N!=N || hash!=idsHash);
+  comm.Allreduce(changed, comm_t::Max);
+
+  if (!changed) {
+    //hand back the owner flags chosen last time
+    if (unique) {
+      for (dlong n=0;n<N;n++)
+        if (ids[n]!=0) ids[n] = ownerFlags[n] ? abs(ids[n]) : -abs(ids[n]);
+    }
+    if (!rank && verbose) {
+      std::cout << "ogs Update: ids unchanged, nothing rebuilt." << std::endl;
+    }
+    return;
+  }
+
+  //operations in flight hold the old exchanges
+  DrainAllSlots();
+  ring->slots.clear();
+  activeSlot = nullptr;
+
+  N = _N;
+  idsHash = hash;
+
+  BuildOperators(ids, setupMethod, {}, verbose, true);
+
+  timePoint_t end = GlobalPlatformTime(platform);
+  double elapsedTime = ElapsedTime(start, end);
+
+  if (!rank && verbose) {
+    std::cout << "ogs Update Time: " << elapsedTime << " seconds." << std::endl;
+  }
+}
+
+//Build the gather operators and the exchange from an id list. On an update,
+// the local gather operators are kept if this rank's node list is unchanged,
+// and the exchange methods tuned at setup are rebuilt rather than re-tuned
+void ogsBase_t::BuildOperators(memory<hlong> ids,
+                               const Method method,
+                               const std::vector<exchangeConfig_t>& configs,
+                               const bool verbose,
+                               const bool update) {
+
+  int rank, size;
+  rank = comm.rank();
+  size = comm.size();
+
+  setupPhase_t phase;
+  if (verbose) phase = StartSetupPhase();
+
   //count how many ids are non-zero
   dlong Nids=0;
-  for (dlong n=0;n<N;n++)
+  hlong maxId=0;
+  for (dlong n=0;n<N;n++) {
     if (ids[n]!=0) Nids++;
+    maxId = std::max(maxId, static_cast<hlong>(abs(ids[n])));
+  }
+
+  //rendezvous each id in a contiguous block of the global id range. Ids
+  // numbered from Scan offsets then land on their own rank or a neighbour,
+  // rather than being scattered to every rank as a modulo hash would
+  comm.Allreduce(maxId, comm_t::Max);
+  const hlong blockSize = std::max<hlong>((maxId+size-1)/size, 1);
 
   // make list of nodes
   memory<parallelNode_t> nodes(Nids);
@@ -115,13 +312,53 @@ void ogsBase_t::Setup(const dlong _N,
       nodes[Nids].baseId = (kind==Unsigned) ?
                             abs(ids[n]) : ids[n]; //record global id
       nodes[Nids].rank = rank;
-      nodes[Nids].destRank = abs(ids[n]) % size;
+      nodes[Nids].destRank = static_cast<int>((abs(ids[n])-1)/blockSize);
       Nids++;
     }
   }
 
-  //flag which nodes are shared via MPI
-  FindSharedNodes(Nids, nodes, verbose);
+  //Flag which nodes are shared via MPI. The nodes are rendezvoused in
+  // batches of bounded size, to cap the memory held by the exchanged
+  // copies. Each batch takes the same sub-range of every rank's id block,
+  // so all the copies of an id meet in the same batch.
+  const dlong batchSize = SetupBatchSize(platform);
+  hlong NidsMax = Nids;
+  comm.Allreduce(NidsMax, comm_t::Max);
+  const int Nbatches = (batchSize>0) ?
+                        static_cast<int>(std::max<hlong>((NidsMax+batchSize-1)/batchSize, 1)) : 1;
+
+  memory<dlong> batchStarts(Nbatches+1, 0);
+  if (Nbatches>1) {
+    auto batch = [=](const parallelNode_t& a) {
+      return ((abs(a.baseId)-1)%blockSize)*Nbatches/blockSize;
+    };
+    RadixSort(Nids, nodes,
+              [=](const parallelNode_t& a) { return static_cast<uint64_t>(batch(a)); });
+    for (dlong n=0;n<Nids;n++) batchStarts[batch(nodes[n])+1]++;
+    for (int b=0;b<Nbatches;b++) batchStarts[b+1] += batchStarts[b];
+  } else {
+    batchStarts[1] = Nids;
+  }
+
+  gather_defined = true;
+  hlong NsharedLabels=0;
+  for (int b=0;b<Nbatches;b++) {
+    const dlong Nbatch = batchStarts[b+1]-batchStarts[b];
+    memory<parallelNode_t> batchNodes = nodes.slice(batchStarts[b], Nbatch);
+    NsharedLabels += FindSharedNodes(Nbatch, batchNodes, verbose && Nbatches==1);
+  }
+  batchStarts.free();
+
+  if (verbose) {
+    comm.Reduce(NsharedLabels, 0);
+    if (!rank) {
+      std::cout << "ogs Setup: " << NsharedLabels << " unique labels shared";
+      if (Nbatches>1) std::cout << " (" << Nbatches << " batches)";
+      std::cout << "." << std::endl;
+    }
+    ReportPhaseMemory(comm, "rendezvous", phase);
+    phase = StartSetupPhase();
+  }
 
   //Index the local and halo baseIds on this rank and
   // construct sharedNodes which contains all the info
@@ -130,30 +367,71 @@ void ogsBase_t::Setup(const dlong _N,
   memory<parallelNode_t> sharedNodes;
   ConstructSharedNodes(Nids, nodes, Nshared, sharedNodes);
 
+  if (verbose) {
+    ReportPhaseMemory(comm, "shared node construction", phase);
+    phase = StartSetupPhase();
+  }
+
+  if (verbose) {
+    hlong NhaloPGlobal = NhaloP;
+    dlong NhaloPMax = NhaloP;
+    comm.Reduce(NhaloPGlobal, 0);
+    comm.Reduce(NhaloPMax, 0, comm_t::Max);
+    if (!rank) {
+      std::cout << "ogs Setup: " << NhaloPGlobal << " positive halo nodes, "
+                << NhaloPMax << " max per rank." << std::endl;
+    }
+  }
+
+  if (unique) ownerFlags.assign(N, false);
+
   Nids=0;
   for (dlong n=0;n<N;n++) {
     if (ids[n]!=0) {
       nodes[Nids].localId = n; //record the real id now
 
       //if we altered the signs of ids, write them back
-      if (unique)
+      if (unique) {
         ids[n] = nodes[Nids].baseId;
+        ownerFlags[n] = (ids[n]>0);
+      }
 
       Nids++;
     }
   }
 
+  //the local gather operators only depend on this rank's node list
+  const uint64_t nodesHash = NodesHash(Nids, nodes);
+  const bool reuseLocal = update && (nodesHash==localHash);
+  localHash = nodesHash;
+
   //setup local gather operators
-  if (kind==Signed)
+  if (reuseLocal) {
+    //keep the operators from the last setup
+  } else if (kind==Signed)
     LocalSignedSetup(Nids, nodes);
   else if (kind==Unsigned)
     LocalUnsignedSetup(Nids, nodes);
   else
     LocalHaloSetup(Nids, nodes);
 
+  if (update && verbose) {
+    int Nreused = reuseLocal ? 1 : 0;
+    comm.Reduce(Nreused, 0);
+    if (!rank) {
+      std::cout << "ogs Update: local operators kept on " << Nreused
+                << " of " << size << " ranks." << std::endl;
+    }
+  }
+
   //with that, we're done with the local nodes list
   nodes.free();
 
+  if (verbose) {
+    ReportPhaseMemory(comm, "local operators", phase);
+    phase = StartSetupPhase();
+  }
+
   // At this point, we've setup gs operators to gather/scatter the purely local nodes,
   // and gather/scatter the shared halo nodes to/from a coalesced ordering. We now
   // need gs operators to scatter/gather the coalesced halo nodes to/from the expected
@@ -174,27 +452,47 @@ void ogsBase_t::Setup(const dlong _N,
                   new ogsCrystalRouter_t(Nshared, sharedNodes,
                                          *gatherHalo, dataStream,
                                          comm, platform));
-  } else { //Auto
+  } else if (method == RMA) {
+    exchange = std::shared_ptr<ogsExchange_t>(
+                  new ogsRMA_t(Nshared, sharedNodes,
+                               *gatherHalo, dataStream,
+                               comm, platform));
+  } else if (method == SharedMemory) {
+    exchange = std::shared_ptr<ogsExchange_t>(
+                  new ogsSharedMemory_t(Nshared, sharedNodes,
+                                        *gatherHalo, dataStream,
+                                        comm, platform));
+  } else if (method == Hierarchical) {
     exchange = std::shared_ptr<ogsExchange_t>(
-                  AutoSetup(Nshared, sharedNodes,
-                            *gatherHalo, comm,
-                            platform, verbose));
+                  new ogsHierarchical_t(Nshared, sharedNodes,
+                                        *gatherHalo, dataStream,
+                                        comm, platform));
+  } else if (method == Hybrid) {
+    exchange = std::shared_ptr<ogsExchange_t>(
+                  new ogsHybrid_t(Nshared, sharedNodes,
+                                  *gatherHalo, dataStream,
+                                  comm, platform,
+                                  HybridThreshold(platform)));
+  } else if (update && tuning) { //Auto, already tuned
+    RebuildExchanges(Nshared, sharedNodes, *gatherHalo);
+  } else { //Auto
+    AutoSetup(Nshared, sharedNodes,
+              *gatherHalo, comm,
+              platform, configs, verbose);
   }
 
-  timePoint_t end = GlobalPlatformTime(platform);
-  double elapsedTime = ElapsedTime(start, end);
+  //the exchanges keep what they need of the shared node list
+  sharedNodes.free();
+
+  if (verbose) ReportPhaseMemory(comm, "exchange setup", phase);
 
-  if (!rank && verbose) {
-    std::cout << "ogs Setup Time: " << elapsedTime << " seconds." << std::endl;
-  }
 }
 
-void ogsBase_t::FindSharedNodes(const dlong Nids,
-                                memory<parallelNode_t> &nodes,
-                                const int verbose){
+dlong ogsBase_t::FindSharedNodes(const dlong Nids,
+                                 memory<parallelNode_t> &nodes,
+                                 const int verbose){
 
-  int rank, size;
-  rank = comm.rank();
+  int size;
   size = comm.size();
 
   memory<int> sendCounts(size,0);
@@ -207,13 +505,9 @@ void ogsBase_t::FindSharedNodes(const dlong Nids,
     sendCounts[nodes[n].destRank]++;
   }
 
-  comm.Alltoall(sendCounts, recvCounts);
-
   sendOffsets[0] = 0;
-  recvOffsets[0] = 0;
   for (int r=0;r<size;r++) {
     sendOffsets[r+1] = sendOffsets[r]+sendCounts[r];
-    recvOffsets[r+1] = recvOffsets[r]+recvCounts[r];
 
     //reset counter
     sendCounts[r] = 0;
@@ -228,13 +522,13 @@ void ogsBase_t::FindSharedNodes(const dlong Nids,
   // permute the list to send ordering
   permute(Nids, nodes, [](const parallelNode_t& a) { return a.newId; } );
 
-  dlong recvN = recvOffsets[size]; //total ids to recv
+  //Send all the nodes to their destination rank. Only the ranks we
+  // actually share ids with are contacted
+  memory<parallelNode_t> recvNodes;
+  comm.SparseAlltoallv(nodes, sendCounts, sendOffsets,
+                       recvNodes, recvCounts, recvOffsets);
 
-  memory<parallelNode_t> recvNodes(recvN);
-
-  //Send all the nodes to their destination rank.
-  comm.Alltoallv(    nodes, sendCounts, sendOffsets,
-                 recvNodes, recvCounts, recvOffsets);
+  dlong recvN = recvOffsets[size]; //total ids recv'd
 
   //remember this ordering
   for (dlong n=0;n<recvN;n++) {
@@ -242,15 +536,16 @@ void ogsBase_t::FindSharedNodes(const dlong Nids,
   }
 
   // sort based on base ids
-  sort(recvNodes.ptr(), recvNodes.ptr()+recvN,
-       [](const parallelNode_t& a, const parallelNode_t& b) {
-         return abs(a.baseId) < abs(b.baseId);
-       });
+  RadixSort(recvN, recvNodes,
+            [](const parallelNode_t& a) { return static_cast<uint64_t>(abs(a.baseId)); });
 
   // We now have a collection of nodes associated with some subset of all global Ids
   // Our list is sorted by baseId to group nodes with the same globalId together
   // We now want to flag which nodes are shared via MPI
 
+  //Make a single node from each baseId group the sole positive node
+  if (unique) AssignOwners(recvN, recvNodes, sendCounts, recvCounts, verbose);
+
   int is_unique=1;
 
   dlong Nshared=0;
@@ -262,16 +557,7 @@ void ogsBase_t::FindSharedNodes(const dlong Nids,
 
       int positiveCount=0;
       if (unique) {
-        //Make a single node from each baseId group the sole positive node
-        const hlong baseId = abs(recvNodes[start].baseId);
-
-        //pick a random node in this group
-        const int m = (rand() % (end-start));
-
-        for (int i=start;i<end;i++)
-          recvNodes[i].baseId = -baseId;
-
-        recvNodes[start+m].baseId = baseId;
+        //the sole positive node of each group was chosen in AssignOwners
         positiveCount=1;
       } else {
         //count how many postive baseIds there are in this group
@@ -310,13 +596,7 @@ void ogsBase_t::FindSharedNodes(const dlong Nids,
 
   //shared the unique node check so we know if the gather operation is well-defined
   comm.Allreduce(is_unique, comm_t::Min);
-  gather_defined = (is_unique==1);
-
-  hlong Nshared_global = Nshared;
-  comm.Reduce(Nshared_global, 0);
-  if (!rank && verbose) {
-    std::cout << "ogs Setup: " << Nshared_global << " unique labels shared." << std::endl;
-  }
+  gather_defined = gather_defined && (is_unique==1);
 
   //at this point each collection of baseIds either has all nodes have
   // sign = 1, meaning all the nodes with this baseId are on the
@@ -326,8 +606,227 @@ void ogsBase_t::FindSharedNodes(const dlong Nids,
   permute(recvN, recvNodes, [](const parallelNode_t& a) { return a.newId; } );
 
   //Return all the nodes to their origin rank.
-  comm.Alltoallv(recvNodes, recvCounts, recvOffsets,
-                     nodes, sendCounts, sendOffsets);
+  comm.NeighborAlltoallv(recvNodes, recvCounts, recvOffsets,
+                             nodes, sendCounts, sendOffsets);
+
+  return Nshared;
+}
+
+//deterministic pseudo-random value in [0,1) for a baseId and rank
+static inline double OwnerHash(const hlong baseId, const int rank) {
+  uint64_t h = static_cast<uint64_t>(baseId)*0x9E3779B97F4A7C15ULL
+             + static_cast<uint64_t>(rank)*0xC2B2AE3D27D4EB4FULL;
+  h ^= h >> 33;
+  h *= 0xFF51AFD7ED558CCDULL;
+  h ^= h >> 33;
+  return static_cast<double>(h >> 11) * 0x1.0p-53;
+}
+
+//owner selection policy for unique gathers, BALANCE unless the
+// application has registered the ogs settings and asked otherwise
+static bool MinimizeCommunication(platform_t& platform) {
+  settings_t& settings = platform.settings();
+  if (settings.settings.find("OGS OWNER POLICY") == settings.settings.end())
+    return false;
+
+  return settings.compareSetting("OGS OWNER POLICY", "COMMUNICATION");
+}
+
+// Choose the owner of each baseId group in recvNodes (sorted by baseId),
+// making its node the sole positive one. Groups on a single rank are owned
+// by that rank. Each shared group goes to the participating rank with the
+// lowest price plus a hash of the baseId, which spreads groups with the
+// same participants between them. Prices start at zero and are raised on
+// ranks owning more than their share over a few rounds, keeping the best
+// assignment found. Ties within a rank go to the lowest local id, so the
+// choice does not depend on the sort order.
+//
+// Counts and prices are only kept for the ranks that sent nodes here. In
+// each round every rank learns its total owned count from the ranks it
+// sent its nodes to, and returns the total to them, so the counts travel
+// over the rendezvous pattern only.
+//
+// With the COMMUNICATION policy, groups shared by three or more ranks (edge
+// and vertex nodes) instead use a hash of the rank alone, with no price,
+// and take no part in the rounds. The ranks then have one priority order,
+// so all groups with the same rank set pick the same owner, and a group
+// inside a larger set picks the larger set's owner whenever it can. This
+// avoids peer pairs beyond those each vertex needs. Two-rank groups need
+// their pair anyway, so they still spread by baseId and are balanced.
+void ogsBase_t::AssignOwners(const dlong recvN,
+                             memory<parallelNode_t> &recvNodes,
+                             const memory<int> sendCounts,
+                             const memory<int> recvCounts,
+                             const int verbose) {
+
+  const int rank = comm.rank();
+  const int size = comm.size();
+
+  const bool minimizeComm = MinimizeCommunication(platform);
+
+  //the ranks whose nodes we hold, and the ranks holding our nodes
+  std::vector<int> peers, rendezvous;
+  for (int r=0;r<size;r++) {
+    if (recvCounts[r]) peers.push_back(r);
+    if (sendCounts[r]) rendezvous.push_back(r);
+  }
+  const int Npeers = static_cast<int>(peers.size());
+  const int Nrendezvous = static_cast<int>(rendezvous.size());
+
+  //one count per neighbour in each direction
+  memory<int> downCounts(size, 0), downOffsets(size+1, 0);
+  memory<int> upCounts(size, 0), upOffsets(size+1, 0);
+  for (int r=0;r<size;r++) {
+    downCounts[r] = recvCounts[r] ? 1 : 0;
+    upCounts[r]   = sendCounts[r] ? 1 : 0;
+    downOffsets[r+1] = downOffsets[r]+downCounts[r];
+    upOffsets[r+1]   = upOffsets[r]+upCounts[r];
+  }
+
+  //index of each node's rank in peers
+  memory<int> nodePeer(recvN);
+  for (dlong n=0;n<recvN;n++)
+    nodePeer[n] = static_cast<int>(std::lower_bound(peers.begin(), peers.end(),
+                                                    recvNodes[n].rank)
+                                   - peers.begin());
+
+  //find the baseId groups, and count the nodes owned by single-rank groups.
+  // Note the shared groups, and whether each is shared by three or more ranks
+  std::vector<std::pair<dlong,dlong>> sharedGroups;
+  std::vector<bool> multiShared;
+  memory<hlong> ownedCounts(Npeers, 0);
+  hlong Ngroups=0;
+
+  dlong start=0;
+  for (dlong n=0;n<recvN;n++) {
+    if (n==recvN-1 || abs(recvNodes[n].baseId)!=abs(recvNodes[n+1].baseId)) {
+      const dlong end = n+1;
+      const int r = recvNodes[start].rank;
+
+      //count the distinct ranks in this group, up to three
+      int r2=r, Nranks=1;
+      for (dlong i=start+1;i<end && Nranks<3;i++) {
+        const int ri = recvNodes[i].rank;
+        if (Nranks==1 && ri!=r) { r2=ri; Nranks=2; }
+        else if (Nranks==2 && ri!=r && ri!=r2) Nranks=3;
+      }
+
+      if (Nranks==1) {
+        ownedCounts[nodePeer[start]]++;
+      } else {
+        sharedGroups.push_back(std::make_pair(start, end));
+        multiShared.push_back(Nranks>2);
+      }
+      Ngroups++;
+
+      start=end;
+    }
+  }
+
+  //node of a group on the participating rank with the lowest price
+  auto Owner = [&](const dlong gstart, const dlong gend,
+                   const memory<double> price, const bool multi) {
+    const bool fixed = minimizeComm && multi;
+    const hlong baseId = fixed ? 0 : abs(recvNodes[gstart].baseId);
+    dlong m=gstart;
+    for (dlong i=gstart+1;i<gend;i++) {
+      const parallelNode_t& a = recvNodes[i];
+      const parallelNode_t& b = recvNodes[m];
+      const double pa = (fixed ? 0.0 : price[nodePeer[i]]) + OwnerHash(baseId, a.rank);
+      const double pb = (fixed ? 0.0 : price[nodePeer[m]]) + OwnerHash(baseId, b.rank);
+      if (std::make_tuple(pa, a.rank, a.localId)
+          < std::make_tuple(pb, b.rank, b.localId)) m=i;
+    }
+    return m;
+  };
+
+  memory<double> price(Npeers, 0.0);
+
+  //groups whose owner ignores the price are counted once, and the rounds
+  // only run if some group anywhere depends on the price
+  memory<hlong> Ntotals(2);
+  Ntotals[0] = Ngroups;
+  Ntotals[1] = 0;
+  for (size_t g=0;g<sharedGroups.size();g++) {
+    if (minimizeComm && multiShared[g]) {
+      ownedCounts[nodePeer[Owner(sharedGroups[g].first, sharedGroups[g].second,
+                                 price, true)]]++;
+    } else {
+      Ntotals[1]++;
+    }
+  }
+  comm.Allreduce(Ntotals);
+  Ngroups = Ntotals[0];
+  const hlong Npriced = Ntotals[1];
+
+  const double share = static_cast<double>(Ngroups)/size;
+
+  //a single round still measures the imbalance for the report
+  const int Nrounds = (Npriced>0) ? 10 : ((verbose && Ngroups>0) ? 1 : 0);
+  memory<double> bestPrice(Npeers, 0.0);
+  memory<hlong> counts(Npeers);
+  memory<hlong> rendezvousCounts(Nrendezvous);
+  memory<hlong> totals(Nrendezvous);
+  hlong bestMax=-1, firstMax=0;
+
+  for (int round=0;round<Nrounds;round++) {
+    counts.copyFrom(ownedCounts);
+    for (size_t g=0;g<sharedGroups.size();g++) {
+      if (minimizeComm && multiShared[g]) continue; //counted in ownedCounts
+      counts[nodePeer[Owner(sharedGroups[g].first, sharedGroups[g].second,
+                            price, false)]]++;
+    }
+
+    //sum our owned count from the ranks holding our nodes, and send the
+    // total back to them
+    comm.NeighborAlltoallv(counts, downCounts, downOffsets,
+                           rendezvousCounts, upCounts, upOffsets);
+    hlong total=0;
+    for (int r=0;r<Nrendezvous;r++) total += rendezvousCounts[r];
+    for (int r=0;r<Nrendezvous;r++) totals[r] = total;
+    comm.NeighborAlltoallv(totals, upCounts, upOffsets,
+                           counts, downCounts, downOffsets);
+
+    hlong countMax=total;
+    comm.Allreduce(countMax, comm_t::Max);
+    if (round==0) firstMax = countMax;
+    if (bestMax<0 || countMax<bestMax) {
+      bestMax = countMax;
+      bestPrice.copyFrom(price);
+    }
+
+    //raise the price of ranks over their share, in shrinking steps
+    const double step = 2.0/(round+1);
+    for (int i=0;i<Npeers;i++)
+      price[i] += step*(counts[i]-share)/share;
+  }
+
+  //mark the owners
+  size_t g=0;
+  start=0;
+  for (dlong n=0;n<recvN;n++) {
+    if (n==recvN-1 || abs(recvNodes[n].baseId)!=abs(recvNodes[n+1].baseId)) {
+      const dlong end = n+1;
+      const hlong baseId = abs(recvNodes[start].baseId);
+
+      bool multi=false;
+      if (g<sharedGroups.size() && sharedGroups[g].first==start) multi = multiShared[g++];
+
+      const dlong m = Owner(start, end, bestPrice, multi);
+
+      for (dlong i=start;i<end;i++)
+        recvNodes[i].baseId = -baseId;
+      recvNodes[m].baseId = baseId;
+
+      start=end;
+    }
+  }
+
+  if (!rank && verbose && Ngroups>0) {
+    std::cout << "ogs Setup: owned node imbalance (max/avg) "
+              << firstMax/share << " before balancing, "
+              << bestMax/share << " after." << std::endl;
+  }
 }
 
 void ogsBase_t::ConstructSharedNodes(const dlong Nids,
@@ -338,13 +837,9 @@ void ogsBase_t::ConstructSharedNodes(const dlong Nids,
   int size = comm.size();
 
   // sort based on abs(baseId)
-  sort(nodes.ptr(), nodes.ptr()+Nids,
-       [](const parallelNode_t& a, const parallelNode_t& b) {
-         if(abs(a.baseId) < abs(b.baseId)) return true; //group by abs(baseId)
-         if(abs(a.baseId) > abs(b.baseId)) return false;
-
-         return a.baseId > b.baseId; //positive ids on a rank first
-       });
+  RadixSort(Nids, nodes,
+            [](const parallelNode_t& a) { return static_cast<uint64_t>(abs(a.baseId)); }, //group by abs(baseId)
+            [](const parallelNode_t& a) { return static_cast<uint64_t>(a.baseId<0); }); //positive ids on a rank first
 
   //count how many unique global Ids we have on this rank
   // and flag baseId groups that have a positive baseId somewhere on this rank
@@ -447,31 +942,24 @@ void ogsBase_t::ConstructSharedNodes(const dlong Nids,
   memory<int> recvOffsets(size+1);
 
   // sort based on destination rank
-  sort(sendSharedNodes.ptr(), sendSharedNodes.ptr()+NhaloT,
-       [](const parallelNode_t& a, const parallelNode_t& b) {
-         return a.destRank < b.destRank;
-       });
+  RadixSort(NhaloT, sendSharedNodes,
+            [](const parallelNode_t& a) { return static_cast<uint64_t>(a.destRank); });
 
   //count number of ids we're sending
   for (dlong n=0;n<NhaloT;n++) {
     sendCounts[sendSharedNodes[n].destRank]++;
   }
 
-  comm.Alltoall(sendCounts, recvCounts);
-
   sendOffsets[0] = 0;
-  recvOffsets[0] = 0;
   for (int r=0;r<size;r++) {
     sendOffsets[r+1] = sendOffsets[r]+sendCounts[r];
-    recvOffsets[r+1] = recvOffsets[r]+recvCounts[r];
   }
-  dlong recvN = recvOffsets[size]; //total ids to recv
-
-  memory<parallelNode_t> recvSharedNodes(recvN);
 
   //Send all the nodes to their destination rank.
-  comm.Alltoallv(sendSharedNodes, sendCounts, sendOffsets,
-                 recvSharedNodes, recvCounts, recvOffsets);
+  memory<parallelNode_t> recvSharedNodes;
+  comm.SparseAlltoallv(sendSharedNodes, sendCounts, sendOffsets,
+                       recvSharedNodes, recvCounts, recvOffsets);
+  dlong recvN = recvOffsets[size]; //total ids recv'd
 
   //free up some space
   sendSharedNodes.free();
@@ -481,10 +969,8 @@ void ogsBase_t::ConstructSharedNodes(const dlong Nids,
   recvOffsets.free();
 
   // sort based on base ids
-  sort(recvSharedNodes.ptr(), recvSharedNodes.ptr()+recvN,
-       [](const parallelNode_t& a, const parallelNode_t& b) {
-         return abs(a.baseId) < abs(b.baseId);
-       });
+  RadixSort(recvN, recvSharedNodes,
+            [](const parallelNode_t& a) { return static_cast<uint64_t>(abs(a.baseId)); });
 
   //count number of shared nodes we will be sending
   memory<int> sharedSendCounts(size,0);
@@ -511,15 +997,10 @@ void ogsBase_t::ConstructSharedNodes(const dlong Nids,
   // rank knows what MPI ranks participate in gathering. We now send this
   // information to the involved ranks.
 
-  //share counts
-  comm.Alltoall(sharedSendCounts, sharedRecvCounts);
-
   //cumulative sum
   sharedSendOffsets[0] = 0;
-  sharedRecvOffsets[0] = 0;
   for (int r=0;r<size;r++) {
     sharedSendOffsets[r+1] = sharedSendOffsets[r]+sharedSendCounts[r];
-    sharedRecvOffsets[r+1] = sharedRecvOffsets[r]+sharedRecvCounts[r];
   }
 
   //make a send buffer
@@ -556,13 +1037,10 @@ void ogsBase_t::ConstructSharedNodes(const dlong Nids,
   }
   recvSharedNodes.free();
 
-  //make sharedNodes to hold the exchange data we recv
-  Nshared = sharedRecvOffsets[size];
-  sharedNodes = memory<parallelNode_t>(Nshared);
-
   //Share all the gathering info
-  comm.Alltoallv(sharedSendNodes, sharedSendCounts, sharedSendOffsets,
-                     sharedNodes, sharedRecvCounts, sharedRecvOffsets);
+  comm.SparseAlltoallv(sharedSendNodes, sharedSendCounts, sharedSendOffsets,
+                           sharedNodes, sharedRecvCounts, sharedRecvOffsets);
+  Nshared = sharedRecvOffsets[size];
 }
 
 //Make local and halo gather operators using nodes list
@@ -851,6 +1329,20 @@ void ogsBase_t::Free() {
   gatherLocal = nullptr;
   gatherHalo = nullptr;
   exchange = nullptr;
+  tuning = nullptr;
+  ownerFlags.clear();
+  idsHash = 0;
+  localHash = 0;
+
+  //drop this handle's slots from a ring it may share with its halos
+  auto& slots = ring->slots;
+  slots.erase(std::remove_if(slots.begin(), slots.end(),
+                             [this](const std::shared_ptr<exchangeSlot_t>& s) {
+                               return s->owner==this;
+                             }),
+              slots.end());
+  ring = std::make_shared<slotRing_t>();
+  activeSlot = nullptr;
   N=0;
   NlocalT=0;
   NhaloT=0;
@@ -863,6 +1355,172 @@ void ogsBase_t::AssertGatherDefined() {
              !gather_defined);
 }
 
+void ogsBase_t::Progress() {
+  if (exchange) exchange->Progress();
+  for (auto& slot : ring->slots) {
+    if (slot->busy) slot->exchange->Progress();
+  }
+}
+
+//Switch to the exchange tuned for this configuration (the first is the default)
+exchangeTimer_t ogsBase_t::SelectExchange(const int k,
+                                          const Transpose trans,
+                                          const bool finish) {
+  int c = 0;
+  if (tuning) {
+    const int Nconfigs = tuning->configs.size();
+    for (int n=0;n<Nconfigs;++n) {
+      if (tuning->configs[n].k==k && tuning->configs[n].trans==trans) {
+        c = n;
+        break;
+      }
+    }
+
+    //re-tune only when an operation starts. Every rank starts operations
+    // in the same order, while completions driven by ogsFuture_t::test do
+    // not line up across ranks, so the collective re-trial never runs from one
+    if (!finish && tuning->RetuneDue(c)) {
+      //operations in flight may be using the exchanges being re-trialled
+      DrainAllSlots();
+      tuning->Retune(c);
+    }
+
+    exchange = tuning->exchanges[c];
+    exchange->gpu_aware = tuning->gpu_aware[c];
+  }
+
+  if (activeSlot) {
+    //asynchronous operations run on their slot's copy of the exchange. The
+    // copy is made when the operation starts and kept until it completes
+    exchangeSlot_t& slot = *activeSlot;
+    if (!slot.busy) {
+      if (slot.source != exchange) {
+        slot.source = exchange;
+        slot.exchange = nullptr;
+        if (slot.tagOffset>0)
+          slot.exchange = std::shared_ptr<ogsExchange_t>(exchange->Clone());
+        if (!slot.exchange) slot.exchange = exchange;
+      }
+      if (slot.exchange != exchange) {
+        slot.exchange->gpu_aware = exchange->gpu_aware;
+        slot.exchange->tagOffset = slot.tagOffset;
+      } else {
+        //no private copy, so earlier operations on this exchange must complete
+        DrainSlots(exchange);
+      }
+    }
+    exchange = slot.exchange;
+  } else {
+    //operations in flight which share this exchange must complete first
+    DrainSlots(exchange);
+  }
+
+  return exchangeTimer_t(tuning, exchange, c, finish);
+}
+
+/**********************************
+* Asynchronous operations
+***********************************/
+//Start an operation in a free slot and return a future for its completion
+ogsFuture_t ogsBase_t::Launch(const std::function<void()>& start,
+                              const std::function<void()>& finish) {
+
+  //copies in flight each get their own range of message tags, which bounds
+  // how many can be in flight given the guaranteed MPI tag range
+  const int Ntags = std::min(64, 32767/comm.size() - 1);
+
+  std::vector<std::shared_ptr<exchangeSlot_t>>& slots = ring->slots;
+
+  std::shared_ptr<exchangeSlot_t> slot;
+  for (auto& s : slots) {
+    if (!s->busy) {
+      slot = s;
+      break;
+    }
+  }
+  if (!slot) {
+    slot = std::make_shared<exchangeSlot_t>();
+    slots.push_back(slot);
+  }
+
+  slot->owner = this;
+  slot->ticket = ++ring->Nlaunched;
+  slot->tagOffset = (Ntags>0) ? comm.size()*(1 + static_cast<int>(slot->ticket % Ntags)) : 0;
+
+  //complete any operation still using these tags
+  if (slot->tagOffset>0) {
+    for (auto& s : slots) {
+      if (s->busy && s->tagOffset==slot->tagOffset) s->Complete();
+    }
+  }
+
+  RunInSlot(*slot, start);
+
+  exchangeSlot_t* s = slot.get();
+  slot->finish = [this, s, finish]() { RunInSlot(*s, finish); };
+  slot->busy = true;
+
+  return ogsFuture_t(slot);
+}
+
+//Run an operation with the slot's exchange and stream tag bound
+void ogsBase_t::RunInSlot(exchangeSlot_t& slot, const std::function<void()>& op) {
+  std::shared_ptr<ogsExchange_t> heldExchange = exchange;
+  exchangeSlot_t* heldSlot = activeSlot;
+  streamTag_t heldTag = dataTag;
+
+  activeSlot = &slot;
+  dataTag = slot.dataTag;
+
+  op();
+
+  slot.dataTag = dataTag;
+
+  exchange = heldExchange;
+  activeSlot = heldSlot;
+  dataTag = heldTag;
+}
+
+//Complete the operations in flight on an exchange, from this handle or
+// any other sharing its ring
+void ogsBase_t::DrainSlots(const std::shared_ptr<ogsExchange_t>& ex) {
+  for (auto& s : ring->slots) {
+    if (s->busy && s->exchange==ex && s.get()!=activeSlot) s->Complete();
+  }
+}
+
+//Complete every operation in flight on the ring
+void ogsBase_t::DrainAllSlots() {
+  for (auto& s : ring->slots) {
+    if (s->busy && s.get()!=activeSlot) s->Complete();
+  }
+}
+
+void exchangeSlot_t::Complete() {
+  if (!busy) return;
+
+  //take the closure first, so the slot can be set up again once it has run
+  std::function<void()> op = std::move(finish);
+  finish = nullptr;
+  op();
+  busy = false;
+}
+
+void ogsFuture_t::wait() {
+  if (slot && slot->busy && slot->ticket==ticket) slot->Complete();
+}
+
+bool ogsFuture_t::test() {
+  if (!slot || !slot->busy || slot->ticket!=ticket) return true;
+
+  slot->exchange->Progress();
+  if (slot->exchange->Ready()) {
+    slot->Complete();
+    return true;
+  }
+  return false;
+}
+
 //Populate the local mapping of the original ids and the gathered ordering
 void ogs_t::SetupGlobalToLocalMapping(memory<dlong> GlobalToLocal) {
 
@@ -885,6 +1543,17 @@ void ogs_t::SetupGlobalToLocalMapping(memory<dlong> GlobalToLocal) {
                        1, NoTrans);
 }
 
+void halo_t::Update(const dlong _N,
+                    memory<hlong> ids,
+                    const bool verbose) {
+  LIBP_ABORT("A halo set up from a gather is updated with its ogs handle",
+             gathered_halo);
+
+  ogsBase_t::Update(_N, ids, verbose);
+
+  Nhalo = NhaloT - NhaloP; //number of extra recieved nodes
+}
+
 void halo_t::SetupFromGather(ogs_t& ogs) {
 
   ogs.AssertGatherDefined();
@@ -892,6 +1561,8 @@ void halo_t::SetupFromGather(ogs_t& ogs) {
   platform = ogs.platform;
   comm = ogs.comm;
 
+  dataStream = platform.device.createStream();
+
   N = ogs.NlocalT + ogs.NhaloT;
 
   Ngather = Ngather;
@@ -913,6 +1584,10 @@ void halo_t::SetupFromGather(ogs_t& ogs) {
   gathered_halo=true;
 
   exchange = ogs.exchange;
+  tuning = ogs.tuning;
+
+  //asynchronous operations of both handles run on the same exchanges
+  ring = ogs.ring;
 }
 
 } //namespace ogs
@@ -0,0 +1,275 @@
+/*
+
+The MIT License (MIT)
+
+Copyright (c) 2017-2022 Tim Warburton, Noel Chalmers, Jesse Chan, Ali Karakus
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+*/
+
+#include "ogs.hpp"
+#include "ogs/ogsUtils.hpp"
+#include "ogs/ogsExchange.hpp"
+#include <atomic>
+
+namespace libp {
+
+namespace ogs {
+
+/*The first word of each rank's segment is the sequence number of the data
+  currently in its send buffer. The next nodeSize words record, for each
+  node-local rank, the last sequence number it has finished reading.*/
+static inline std::atomic<hlong>* SegmentFlags(char* segment) {
+  return reinterpret_cast<std::atomic<hlong>*>(segment);
+}
+
+/**********************************
+* Host exchange
+***********************************/
+template<typename T>
+inline void ogsSharedMemory_t::Start(pinnedMemory<T> &buf, const int k,
+                                     const Op op, const Transpose trans){
+
+  pinnedMemory<T> sendBuf = h_sendspace;
+  T* shmSendBuf = reinterpret_cast<T*>(segments[nodeRank] + headerBytes);
+
+  const int NranksSend  = (trans==NoTrans) ? NranksSendN  : NranksSendT;
+  const int NranksRecv  = (trans==NoTrans) ? NranksRecvN  : NranksRecvT;
+  const int *sendRanks  = (trans==NoTrans) ? sendRanksN.ptr()   : sendRanksT.ptr();
+  const int *recvRanks  = (trans==NoTrans) ? recvRanksN.ptr()   : recvRanksT.ptr();
+  const int *sendCounts = (trans==NoTrans) ? sendCountsN.ptr()  : sendCountsT.ptr();
+  const int *recvCounts = (trans==NoTrans) ? recvCountsN.ptr()  : recvCountsT.ptr();
+  const int *sendOffsets= (trans==NoTrans) ? sendOffsetsN.ptr() : sendOffsetsT.ptr();
+  const int *recvOffsets= (trans==NoTrans) ? recvOffsetsN.ptr() : recvOffsetsT.ptr();
+  const int *nodeSendRanks = (trans==NoTrans) ? nodeSendRanksN.ptr() : nodeSendRanksT.ptr();
+  const int *nodeRecvRanks = (trans==NoTrans) ? nodeRecvRanksN.ptr() : nodeRecvRanksT.ptr();
+  const dlong *sendIds  = (trans==NoTrans) ? sendIdsN.ptr() : sendIdsT.ptr();
+
+  std::atomic<hlong>* flags = SegmentFlags(segments[nodeRank]);
+
+  //wait for node-local peers to finish reading our last send buffer
+  for (int r=0;r<nodeSize;r++) {
+    while (flags[1+r].load(std::memory_order_acquire) < lastSent[r]) {}
+  }
+
+  seq++;
+
+  //post recvs from off-node peers
+  Nrequests=0;
+  for (int r=0;r<NranksRecv;r++) {
+    if (nodeRecvRanks[r]>=0) continue;
+    comm.Irecv(buf + Nhalo*k + recvOffsets[r]*k,
+               recvRanks[r],
+               k*recvCounts[r],
+               recvRanks[r],
+               requests[Nrequests++]);
+  }
+
+  // extract the send buffer, writing data for node-local
+  // peers straight into our shared segment
+  const T* buf_ptr = buf.ptr();
+  for (int r=0;r<NranksSend;r++) {
+    T* sendBuf_ptr = (nodeSendRanks[r]<0) ? sendBuf.ptr() : shmSendBuf;
+    for (dlong n=sendOffsets[r];n<sendOffsets[r+1];n++) {
+      const dlong id = sendIds[n];
+      for (int j=0;j<k;j++) {
+        sendBuf_ptr[j+n*k] = buf_ptr[j+id*k];
+      }
+    }
+  }
+
+  //publish the send buffer to node-local peers
+  flags[0].store(seq, std::memory_order_release);
+
+  //post sends to off-node peers
+  for (int r=0;r<NranksSend;r++) {
+    RecordSend(sendRanks[r], k*sendCounts[r]*sizeof(T));
+    if (nodeSendRanks[r]>=0) {
+      lastSent[nodeSendRanks[r]] = seq;
+      continue;
+    }
+    comm.Isend(sendBuf + sendOffsets[r]*k,
+              sendRanks[r],
+              k*sendCounts[r],
+              rank,
+              requests[Nrequests++]);
+  }
+}
+
+template<typename T>
+inline void ogsSharedMemory_t::Finish(pinnedMemory<T> &buf, const int k,
+                                      const Op op, const Transpose trans){
+
+  const int NranksRecv  = (trans==NoTrans) ? NranksRecvN  : NranksRecvT;
+  const int *recvCounts = (trans==NoTrans) ? recvCountsN.ptr()  : recvCountsT.ptr();
+  const int *recvOffsets= (trans==NoTrans) ? recvOffsetsN.ptr() : recvOffsetsT.ptr();
+  const int *nodeRecvRanks = (trans==NoTrans) ? nodeRecvRanksN.ptr() : nodeRecvRanksT.ptr();
+  const int *peerOffsets   = (trans==NoTrans) ? peerOffsetsN.ptr()   : peerOffsetsT.ptr();
+
+  //read directly from node-local peers' send buffers. This must happen
+  // before waiting on MPI so that peers are never blocked on us
+  for (int r=0;r<NranksRecv;r++) {
+    const int nr = nodeRecvRanks[r];
+    if (nr<0) continue;
+
+    std::atomic<hlong>* peerFlags = SegmentFlags(segments[nr]);
+    timePoint_t wait = Time();
+    while (peerFlags[0].load(std::memory_order_acquire) < seq) {}
+    RecordWait(wait);
+
+    const T* peerSendBuf = reinterpret_cast<const T*>(segments[nr] + headerBytes);
+    std::copy(peerSendBuf + peerOffsets[r]*k,
+              peerSendBuf + peerOffsets[r]*k + recvCounts[r]*k,
+              buf.ptr() + Nhalo*k + recvOffsets[r]*k);
+
+    //let the peer know we're done with its buffer
+    peerFlags[1+nodeRank].store(seq, std::memory_order_release);
+  }
+
+  timePoint_t wait = Time();
+  comm.Waitall(Nrequests, requests);
+  RecordWait(wait);
+
+  //if we recvieved anything via MPI, gather the recv buffer and scatter
+  // it back to to original vector
+  dlong Nrecv = recvOffsets[NranksRecv];
+  if (Nrecv) {
+    // gather the recieved nodes
+    postmpi.Gather(buf, buf, k, op, trans);
+  }
+}
+
+void ogsSharedMemory_t::Start(pinnedMemory<float> &buf, const int k, const Op op, const Transpose trans) { Start<float>(buf, k, op, trans); }
+void ogsSharedMemory_t::Start(pinnedMemory<double> &buf, const int k, const Op op, const Transpose trans) { Start<double>(buf, k, op, trans); }
+void ogsSharedMemory_t::Start(pinnedMemory<int> &buf, const int k, const Op op, const Transpose trans) { Start<int>(buf, k, op, trans); }
+void ogsSharedMemory_t::Start(pinnedMemory<long long int> &buf, const int k, const Op op, const Transpose trans) { Start<long long int>(buf, k, op, trans); }
+void ogsSharedMemory_t::Finish(pinnedMemory<float> &buf, const int k, const Op op, const Transpose trans) { Finish<float>(buf, k, op, trans); }
+void ogsSharedMemory_t::Finish(pinnedMemory<double> &buf, const int k, const Op op, const Transpose trans) { Finish<double>(buf, k, op, trans); }
+void ogsSharedMemory_t::Finish(pinnedMemory<int> &buf, const int k, const Op op, const Transpose trans) { Finish<int>(buf, k, op, trans); }
+void ogsSharedMemory_t::Finish(pinnedMemory<long long int> &buf, const int k, const Op op, const Transpose trans) { Finish<long long int>(buf, k, op, trans); }
+
+ogsSharedMemory_t::ogsSharedMemory_t(dlong Nshared,
+                                     memory<parallelNode_t> &sharedNodes,
+                                     ogsOperator_t& gatherHalo,
+                                     stream_t _dataStream,
+                                     comm_t _comm,
+                                     platform_t &_platform):
+  ogsPairwise_t(Nshared, sharedNodes, gatherHalo,
+                _dataStream, _comm, _platform) {
+
+  //node-local copies do not use the pairwise staging pipeline
+  staged = false;
+
+  //find the ranks which share our node
+  nodeComm = comm.SplitShared(rank);
+  nodeRank = nodeComm.rank();
+  nodeSize = nodeComm.size();
+
+  memory<int> nodeRanks(nodeSize);
+  nodeComm.Allgather(rank, nodeRanks);
+
+  memory<int> globalToNode(size, -1);
+  for (int r=0;r<nodeSize;r++)
+    globalToNode[nodeRanks[r]] = r;
+
+  nodeSendRanksN.malloc(NranksSendN);
+  nodeSendRanksT.malloc(NranksSendT);
+  nodeRecvRanksN.malloc(NranksRecvN);
+  nodeRecvRanksT.malloc(NranksRecvT);
+  for (int r=0;r<NranksSendN;r++) nodeSendRanksN[r] = globalToNode[sendRanksN[r]];
+  for (int r=0;r<NranksSendT;r++) nodeSendRanksT[r] = globalToNode[sendRanksT[r]];
+  for (int r=0;r<NranksRecvN;r++) nodeRecvRanksN[r] = globalToNode[recvRanksN[r]];
+  for (int r=0;r<NranksRecvT;r++) nodeRecvRanksT[r] = globalToNode[recvRanksT[r]];
+
+  //tell each neighbour where its data sits in our send buffer
+  peerOffsetsN.malloc(NranksRecvN);
+  peerOffsetsT.malloc(NranksRecvT);
+
+  memory<comm_t::request_t> offsRequests(NranksSendN+NranksSendT
+                                         +NranksRecvN+NranksRecvT);
+  int Noffs=0;
+  for (int r=0;r<NranksRecvN;r++)
+    comm.Irecv(peerOffsetsN[r], recvRanksN[r], 0, offsRequests[Noffs++]);
+  for (int r=0;r<NranksRecvT;r++)
+    comm.Irecv(peerOffsetsT[r], recvRanksT[r], 1, offsRequests[Noffs++]);
+  for (int r=0;r<NranksSendN;r++)
+    comm.Isend(sendOffsetsN[r], sendRanksN[r], 0, offsRequests[Noffs++]);
+  for (int r=0;r<NranksSendT;r++)
+    comm.Isend(sendOffsetsT[r], sendRanksT[r], 1, offsRequests[Noffs++]);
+  comm.Waitall(Noffs, offsRequests);
+
+  segments.malloc(nodeSize);
+  lastSent.malloc(nodeSize);
+
+  //make scratch space and the shared segment
+  AllocBuffer(sizeof(dfloat));
+}
+
+ogsSharedMemory_t::~ogsSharedMemory_t() {
+  FreeSegment();
+}
+
+void ogsSharedMemory_t::FreeSegment() {
+  if (!shmWinCreated) return;
+
+  //make sure no peer is still reading from our segment
+  nodeComm.Barrier();
+  nodeComm.WinUnlockAll(shmWin);
+  nodeComm.WinFree(shmWin);
+  shmWinCreated=false;
+}
+
+void ogsSharedMemory_t::AllocBuffer(size_t Nbytes) {
+  ogsPairwise_t::AllocBuffer(Nbytes);
+
+  //the segment is allocated collectively across the node, so regrow
+  // on the word size rather than this rank's buffer size
+  if (Nbytes <= NbytesShm) return;
+
+  FreeSegment();
+
+  //keep the send buffer cache-line aligned
+  headerBytes = (((nodeSize+1)*sizeof(hlong) + 63)/64)*64;
+
+  char* segment = nodeComm.WinAllocateShared<char>(headerBytes + NsendT*Nbytes,
+                                                   shmWin);
+  shmWinCreated=true;
+  nodeComm.WinLockAll(shmWin);
+
+  std::atomic<hlong>* flags = SegmentFlags(segment);
+  for (int r=0;r<nodeSize+1;r++)
+    new (flags+r) std::atomic<hlong>(0);
+
+  for (int r=0;r<nodeSize;r++) {
+    segments[r] = nodeComm.WinSharedQuery<char>(r, shmWin);
+    lastSent[r] = 0;
+  }
+  seq = 0;
+
+  //wait for every peer's flags to be initialized
+  nodeComm.WinSync(shmWin);
+  nodeComm.Barrier();
+
+  NbytesShm = Nbytes;
+}
+
+} //namespace ogs
+
+} //namespace libp
@@ -0,0 +1,163 @@
+/*
+
+The MIT License (MIT)
+
+Copyright (c) 2017-2022 Tim Warburton, Noel Chalmers, Jesse Chan, Ali Karakus
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+*/
+#include "ogs.hpp"
+#include "ogs/ogsExchange.hpp"
+#include <map>
+#include <fstream>
+
+namespace libp {
+
+namespace ogs {
+
+/*
+  Per-neighbour exchange statistics. When enabled, each exchange records
+  the number and size of the messages it sends to every peer, along with
+  the time from Start to Finish and the time spent blocked waiting on
+  communication. Peers are recorded by their rank in MPI_COMM_WORLD so
+  exchanges over sub-communicators can be reported together.
+*/
+
+struct peerStats_t {
+  size_t messages=0;
+  size_t bytes=0;
+};
+
+static bool statsEnabled=false;
+static std::map<int, peerStats_t> peerStats;
+static size_t Nexchanges=0;
+static double exchangeTime=0.0;
+static double waitTime=0.0;
+
+void EnableStats(const bool enable) {
+  statsEnabled = enable;
+}
+
+void ogsExchange_t::RecordSend(const int peer, const size_t bytes) {
+  if (!statsEnabled) return;
+
+  if (worldRanks.length()==0) worldRanks = comm.WorldRanks();
+
+  peerStats_t& stats = peerStats[worldRanks[peer]];
+  stats.messages++;
+  stats.bytes += bytes;
+}
+
+void ogsExchange_t::RecordWait(const timePoint_t start) {
+  if (!statsEnabled) return;
+  waitTime += ElapsedTime(start, Time());
+}
+
+void ogsExchange_t::RecordStart() {
+  if (!statsEnabled) return;
+  statsStart = Time();
+}
+
+void ogsExchange_t::RecordFinish() {
+  if (!statsEnabled) return;
+  exchangeTime += ElapsedTime(statsStart, Time());
+  Nexchanges++;
+}
+
+template<typename T>
+static void ReportStat(comm_t comm, const char* name, const T value) {
+  T minValue = value, maxValue = value;
+  double sumValue = static_cast<double>(value);
+  comm.Allreduce(minValue, comm_t::Min);
+  comm.Allreduce(maxValue, comm_t::Max);
+  comm.Allreduce(sumValue, comm_t::Sum);
+
+  if (comm.rank()==0) {
+    printf("ogs: %-24s %12.4e %12.4e %12.4e\n", name,
+           static_cast<double>(minValue),
+           sumValue/comm.size(),
+           static_cast<double>(maxValue));
+  }
+}
+
+void ReportStats(comm_t comm, const std::string filename) {
+
+  const int rank = comm.rank();
+  const int size = comm.size();
+
+  //rank in comm of each world rank we sent to
+  memory<int> worldRanks = comm.WorldRanks();
+  std::map<int, int> commRanks;
+  for (int r=0;r<size;++r) commRanks[worldRanks[r]] = r;
+
+  int Npeers = 0;
+  hlong Nmessages = 0;
+  hlong Nbytes = 0;
+  memory<hlong> row(size);
+  for (int r=0;r<size;++r) row[r] = 0;
+
+  for (auto& p : peerStats) {
+    Npeers++;
+    Nmessages += p.second.messages;
+    Nbytes += p.second.bytes;
+
+    auto c = commRanks.find(p.first);
+    if (c != commRanks.end()) row[c->second] = p.second.bytes;
+  }
+
+  const hlong Nexch = Nexchanges;
+
+  if (rank==0) {
+    printf("ogs: exchange statistics over %d ranks\n", size);
+    printf("ogs: %-24s %12s %12s %12s\n", "", "min", "avg", "max");
+  }
+  ReportStat(comm, "peers", Npeers);
+  ReportStat(comm, "exchanges", Nexch);
+  ReportStat(comm, "messages sent", Nmessages);
+  ReportStat(comm, "bytes sent", Nbytes);
+  ReportStat(comm, "start to finish (s)", exchangeTime);
+  ReportStat(comm, "waiting (s)", waitTime);
+
+  if (filename.empty()) return;
+
+  //bytes sent from each rank (row) to each rank (column)
+  memory<hlong> matrix;
+  if (rank==0) matrix.malloc(static_cast<size_t>(size)*size);
+  comm.Gather(row, matrix, 0);
+
+  if (rank==0) {
+    std::ofstream file(filename);
+    LIBP_ABORT("Unable to open ogs communication matrix file " << filename,
+               !file.is_open());
+
+    file << "rank";
+    for (int c=0;c<size;++c) file << "," << c;
+    file << "\n";
+    for (int r=0;r<size;++r) {
+      file << r;
+      for (int c=0;c<size;++c) file << "," << matrix[static_cast<size_t>(r)*size+c];
+      file << "\n";
+    }
+  }
+}
+
+} //namespace ogs
+
+} //namespace libp
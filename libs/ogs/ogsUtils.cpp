@@ -34,13 +34,15 @@ namespace libp {
 
 namespace ogs {
 
-stream_t ogsBase_t::dataStream;
-
 kernel_t ogsOperator_t::gatherScatterKernel[4][4];
 kernel_t ogsOperator_t::gatherKernel[4][4];
 kernel_t ogsOperator_t::scatterKernel[4];
 
 kernel_t ogsExchange_t::extractKernel[4];
+kernel_t ogsExchange_t::downConvertKernel;
+kernel_t ogsExchange_t::upConvertKernel;
+kernel_t ogsExchange_t::packFieldsKernel;
+kernel_t ogsExchange_t::unpackFieldsKernel;
 
 
 void InitializeKernels(platform_t& platform, const Type type, const Op op) {
@@ -118,6 +120,22 @@ void InitializeKernels(platform_t& platform, const Type type, const Op op) {
 
       ogsExchange_t::extractKernel[type] = platform.buildKernel(OGS_DIR "/okl/ogsKernels.okl",
                                                 "extract", kernelInfo);\
+
+      //precision conversion kernels for reduced precision exchanges
+      if (type==Double) {
+        ogsExchange_t::downConvertKernel = platform.buildKernel(OGS_DIR "/okl/ogsKernels.okl",
+                                                  "downConvert", kernelInfo);
+        ogsExchange_t::upConvertKernel = platform.buildKernel(OGS_DIR "/okl/ogsKernels.okl",
+                                                "upConvert", kernelInfo);
+      }
+
+      //field packing kernels for aggregated exchanges
+      if (type==Int32) {
+        ogsExchange_t::packFieldsKernel = platform.buildKernel(OGS_DIR "/okl/ogsKernels.okl",
+                                                 "packFields", kernelInfo);
+        ogsExchange_t::unpackFieldsKernel = platform.buildKernel(OGS_DIR "/okl/ogsKernels.okl",
+                                                   "unpackFields", kernelInfo);
+      }
     }
   }
 }
@@ -39,6 +39,11 @@ void hipBone_t::Operator(deviceMemory<dfloat> &o_q, deviceMemory<dfloat> &o_Aq){
                    lambda, o_q, o_AqL);
   }
 
+  //poll the halo exchange once, after the local elements are queued. This
+  // only advances messages which have already arrived; progress during the
+  // kernels themselves comes from the OGS PROGRESS THREAD option
+  mesh.gHalo.Progress();
+
   // finalize halo exchange
   mesh.gHalo.ExchangeFinish(o_q, 1);
 
@@ -63,6 +68,9 @@ void hipBone_t::Operator(deviceMemory<dfloat> &o_q, deviceMemory<dfloat> &o_Aq){
                    lambda, o_q, o_AqL);
   }
 
+  //poll the gather exchange once, as for the halo exchange above
+  mesh.ogsMasked.Progress();
+
   mesh.ogsMasked.GatherFinish(o_Aq, o_AqL, 1, ogs::Add, ogs::Trans);
 }
 
@@ -72,6 +72,24 @@ void hipBone_t::Run(){
   timePoint_t endTime = GlobalPlatformTime(platform);
   double elapsedTime = ElapsedTime(startTime, endTime);
 
+  //report the convergence impact of a reduced precision halo exchange
+  bool reducedHalo = mesh.gHalo.reduced_precision
+                     && std::is_same<dfloat, double>::value;
+  dfloat rnorm = 0.0, rnormRef = 0.0;
+  if (reducedHalo) {
+    rnorm = platform.linAlg().norm2(N, o_r, mesh.comm);
+
+    //repeat the solve with a full precision halo for reference
+    platform.linAlg().set(Nall, 0.0, o_x);
+    forcingKernel(N, o_r);
+
+    mesh.gHalo.SetReducedPrecision(false);
+    linearSolver.Solve(*this, o_x, o_r, tol, maxIter, /* verbose = */ 0);
+    mesh.gHalo.SetReducedPrecision(true);
+
+    rnormRef = platform.linAlg().norm2(N, o_r, mesh.comm);
+  }
+
   int Np = mesh.Np, Nq = mesh.Nq;
 
   hlong NunMaskedGlobal = NLocal - mesh.Nmasked;
@@ -117,4 +135,21 @@ void hipBone_t::Run(){
 
     printf("hipBone: NekBone FOM = %4.1f GFLOPs. \n", NflopsNekbone/(1.0e9 * elapsedTime));
   }
+
+  if (reducedHalo) {
+    //halo values received across all ranks in each exchange
+    hlong NhaloGlobal = Nhalo;
+    mesh.comm.Allreduce(NhaloGlobal);
+
+    size_t NbytesHalo = NhaloGlobal*sizeof(float)*(Niter+1);
+    size_t NbytesSaved = NhaloGlobal*(sizeof(double)-sizeof(float))*(Niter+1);
+
+    if (mesh.rank==0){
+      printf("hipBone: %1.4e, %1.4e, %1.2e, %1.2e; final residual (float halo), final residual (double halo), halo MB sent, halo MB saved \n",
+             rnorm,
+             rnormRef,
+             NbytesHalo/1.0e6,
+             NbytesSaved/1.0e6);
+    }
+  }
 }
@@ -32,6 +32,7 @@ hipBoneSettings_t::hipBoneSettings_t(const int argc, char** argv, comm_t _comm):
 
   platformAddSettings(*this);
   meshAddSettings(*this);
+  ogsAddSettings(*this);
 
   newSetting("-v", "--verbose",
              "VERBOSE",
@@ -39,6 +40,12 @@ hipBoneSettings_t::hipBoneSettings_t(const int argc, char** argv, comm_t _comm):
              "Enable verbose output",
              {"TRUE", "FALSE"});
 
+  newSetting("-hp", "--halo-precision",
+             "HALO PRECISION",
+             "DOUBLE",
+             "Precision of halo exchange messages",
+             {"DOUBLE", "FLOAT"});
+
   parseSettings(argc, argv);
 }
 
@@ -48,5 +55,7 @@ void hipBoneSettings_t::report() {
     std::cout << "Settings:\n\n";
     platformReportSettings(*this);
     meshReportSettings(*this);
+    ogsReportSettings(*this);
+    reportSetting("HALO PRECISION");
   }
 }
@@ -39,6 +39,18 @@ void hipBone_t::Setup(platform_t& _platform, mesh_t& _mesh){
   //Trigger JIT kernel builds
   ogs::InitializeKernels(platform, ogs::Dfloat, ogs::Add);
 
+  //optionally exchange the halo of the CG search direction in single precision
+  if (platform.settings().compareSetting("HALO PRECISION", "FLOAT"))
+    mesh.gHalo.SetReducedPrecision(true);
+
+  //optionally progress MPI from a separate thread during the Ax kernels
+  if (platform.settings().compareSetting("OGS PROGRESS THREAD", "TRUE"))
+    ogs::StartProgressThread(mesh.comm);
+
+  //optionally record per-neighbour statistics of the exchanges during the solve
+  if (platform.settings().compareSetting("OGS STATS", "TRUE"))
+    ogs::EnableStats();
+
   //tmp local storage buffer for Ax op
   o_AqL = platform.malloc<dfloat>(mesh.Np*mesh.Nelements);
 